@@ -0,0 +1,96 @@
+// Compares cold (Assimp) and warm (cooked mesh cache) load times for every
+// model under models/. Only the CPU side is measured: no GL context is
+// created and images are not decoded, so the numbers isolate what the cache
+// replaces.
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+
+#include <AssimpLoader.hpp>
+#include <MeshCache.hpp>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    template <typename F>
+    double time_ms(F&& f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Sum over the streams so the warm path actually pages in the mapping
+    double touch(const AssimpLoader::ModelData& model)
+    {
+        double sum = 0.0;
+        for (const auto& mesh : model.meshes)
+        {
+            const auto* vertices = static_cast<const unsigned char*>(mesh.vertex_data());
+            for (std::size_t i = 0; i < mesh.vertex_bytes(); i += 64)
+                sum += vertices[i];
+            const unsigned int* indices = mesh.index_data();
+            for (std::size_t i = 0; i < mesh.index_count(); ++i)
+                sum += indices[i];
+        }
+        return sum;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const fs::path root = fs::path{__FILE__}.parent_path().parent_path();
+    const fs::path models_dir = argc > 1 ? fs::path{argv[1]} : root / "models";
+    const int runs = 5;
+
+    MeshCache::set_directory(fs::temp_directory_path() / "mesh_cache_bench");
+
+    std::vector<fs::path> sources;
+    for (const auto& entry : fs::recursive_directory_iterator(models_dir))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".gltf")
+            sources.push_back(entry.path());
+    }
+
+    std::printf("%-40s %8s %12s %12s %9s\n", "model", "meshes", "cold (ms)", "warm (ms)", "speedup");
+
+    double total_cold = 0.0;
+    double total_warm = 0.0;
+    volatile double sink = 0.0;
+
+    for (const auto& source : sources)
+    {
+        AssimpLoader::ModelData cold;
+        double cold_ms = time_ms([&]() { cold = AssimpLoader::parseModel(source); sink = sink + touch(cold); });
+        if (cold.meshes.empty() || !MeshCache::write(source, cold))
+        {
+            std::printf("%-40s failed to import or cook\n", source.filename().string().c_str());
+            continue;
+        }
+
+        // Best of several runs: the first warm read may still hit a cold page cache
+        double warm_ms = 1e30;
+        for (int run = 0; run < runs; ++run)
+        {
+            warm_ms = std::min(warm_ms, time_ms([&]() {
+                AssimpLoader::ModelData warm;
+                if (MeshCache::read(source, warm))
+                    sink = sink + touch(warm);
+            }));
+        }
+
+        total_cold += cold_ms;
+        total_warm += warm_ms;
+        std::printf("%-40s %8zu %12.2f %12.2f %8.1fx\n", source.lexically_relative(models_dir).string().c_str(),
+                    cold.meshes.size(), cold_ms, warm_ms, cold_ms / warm_ms);
+    }
+
+    std::printf("%-40s %8s %12.2f %12.2f %8.1fx\n", "total", "", total_cold, total_warm,
+                total_warm > 0.0 ? total_cold / total_warm : 0.0);
+
+    return EXIT_SUCCESS;
+}
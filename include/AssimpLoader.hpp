@@ -1,13 +1,19 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 #include <filesystem>
+#include <future>
+#include <string>
+#include <unordered_map>
 
 #include <Mesh.hpp>
 #include <Texture.hpp>
 #include <glm/glm.hpp>
 
+class MappedFile;
+
 namespace AssimpLoader
 {
     // A small renderable bundle: geometry + optional textures + local transform
@@ -15,6 +21,9 @@ namespace AssimpLoader
         std::shared_ptr<Mesh> mesh;
         std::shared_ptr<Texture> albedo; // may be nullptr
         std::shared_ptr<Texture> normal; // may be nullptr
+        // False when `normal` is only the flat fallback: such parts can be
+        // drawn with a variant that skips normal mapping
+        bool has_normal_map{false};
         glm::mat4 transform{1.0f};
         // Original mesh bounds in source space (before we apply the transform
         // that aligns minY to 0). These are useful for stacking objects on
@@ -23,6 +32,71 @@ namespace AssimpLoader
         glm::vec3 src_max{0.0f};
     };
 
+    // CPU-side result for one aiMesh: the final vertex stream in `format`
+    // (11 floats or Mesh::PackedVertex per vertex) plus everything a
+    // Renderable needs, without any GL object created yet.
+    struct MeshData {
+        Mesh::VertexFormat format{Mesh::VertexFormat::FLOAT};
+        std::vector<GLfloat> vertices;                    // FLOAT
+        std::vector<Mesh::PackedVertex> packed_vertices;  // PACKED
+        std::vector<unsigned int> indices;
+        // When the model comes from the cooked mesh cache the streams point
+        // straight into the mapped file and the vectors above stay empty.
+        const void* mapped_vertices{nullptr};
+        const unsigned int* mapped_indices{nullptr};
+        std::size_t mapped_vertex_count{0};
+        std::size_t mapped_index_count{0};
+        glm::mat4 transform{1.0f};
+        glm::vec3 src_min{0.0f};
+        glm::vec3 src_max{0.0f};
+        std::filesystem::path albedo_path; // empty if the material has none
+        std::filesystem::path normal_path; // empty if the material has none
+
+        const void* vertex_data() const noexcept {
+            if (mapped_vertices) return mapped_vertices;
+            if (format == Mesh::VertexFormat::PACKED) return packed_vertices.data();
+            return vertices.data();
+        }
+        std::size_t vertex_count() const noexcept {
+            if (mapped_vertices) return mapped_vertex_count;
+            if (format == Mesh::VertexFormat::PACKED) return packed_vertices.size();
+            return vertices.size() / 11;
+        }
+        std::size_t vertex_bytes() const noexcept { return vertex_count() * Mesh::get_vertex_size(format); }
+        const unsigned int* index_data() const noexcept { return mapped_indices ? mapped_indices : indices.data(); }
+        std::size_t index_count() const noexcept { return mapped_indices ? mapped_index_count : indices.size(); }
+    };
+
+    // CPU-side result for a whole model file. Images referenced by the
+    // meshes are decoded once per model and keyed by their path string.
+    struct ModelData {
+        std::filesystem::path path;
+        std::vector<MeshData> meshes;
+        std::unordered_map<std::string, TextureImage> images;
+        // Keeps the cooked cache file mapped until the model is uploaded
+        std::shared_ptr<const MappedFile> mapping;
+        bool from_cache{false};
+    };
+
+    // Run Assimp on the file and build the CPU-side meshes (vertex
+    // conversion, tangents, grounding). Meshes use `format` where their UVs
+    // allow it (see Mesh::can_pack) and FLOAT otherwise. Does not consult
+    // the mesh cache and does not decode images.
+    ModelData parseModel(const std::filesystem::path& path, Mesh::VertexFormat format = Mesh::VertexFormat::PACKED) noexcept;
+
+    // Read the model from the cooked mesh cache, or parse it with Assimp and
+    // refresh the cache, then decode its images. Touches no GL state, so it
+    // is safe on any thread.
+    ModelData importModel(const std::filesystem::path& path) noexcept;
+
+    // Create the GL meshes and textures for an imported model. Must run on
+    // the thread that owns the GL context.
+    std::vector<Renderable> uploadModel(const ModelData& model) noexcept;
+
+    // Run importModel on the shared loader pool. The caller keeps presenting
+    // frames, polls the future and passes the result to uploadModel.
+    std::future<ModelData> loadModelAsync(const std::filesystem::path& path) noexcept;
+
     // Load a model file (e.g., .gltf) and return one or more Renderable objects
     // ready to be rendered by your existing system. Each Renderable.mesh will
     // contain vertices in the format expected by Mesh::create: pos(3), normal(3), uv(2).
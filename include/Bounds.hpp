@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// World-space bounds of an object: an axis-aligned box, and a sphere around
+// it for the tests that are cheaper with one (light ranges, spot cones).
+// The sphere is centered on the box but is usually tighter than the box's
+// half diagonal.
+struct Bounds
+{
+    glm::vec3 min{0.0f};
+    glm::vec3 max{0.0f};
+    glm::vec3 center{0.0f};
+    float radius{0.0f};
+
+    // Bounds of the local box [local_min, local_max] under `transform`: the
+    // box around its eight transformed corners, and the sphere reaching the
+    // farthest of them
+    static Bounds transformed(const glm::vec3& local_min, const glm::vec3& local_max, const glm::mat4& transform) noexcept;
+
+    // Grow to enclose `other`
+    void merge(const Bounds& other) noexcept;
+};
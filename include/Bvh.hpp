@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Bounds.hpp>
+
+// Bounding volume hierarchy over world bounds. Queries take the same
+// visible(bounds) predicates as Scene::cull (a frustum, a light's range, a
+// spot cone...): a node whose bounds fail the predicate is skipped with its
+// whole subtree, so a query costs about the log of the item count plus the
+// items found. Nodes are stored parents first, so refit() updates every box
+// in one backward sweep after items move.
+class Bvh
+{
+public:
+    struct Item
+    {
+        Bounds bounds;
+        // Caller's identifier, handed back by query()
+        std::uint32_t id{0};
+    };
+
+    // Items per leaf
+    static constexpr std::uint32_t LEAF_SIZE = 4;
+
+    Bvh() = default;
+
+    Bvh(const Bvh& bvh) = delete;
+
+    Bvh(Bvh&& bvh) = delete;
+
+    Bvh& operator = (const Bvh& bvh) = delete;
+
+    Bvh& operator = (Bvh&& bvh) = delete;
+
+    // Build from scratch, splitting at the median along each node's
+    // longest axis
+    void build(std::vector<Item> items) noexcept;
+
+    // Fetch the current bounds of every item with lookup(id, bounds) and
+    // refit the boxes around them. The tree shape is kept, so it is
+    // cheap but loosens as items travel; see needs_rebuild().
+    template <typename Lookup>
+    void refit(Lookup&& lookup) noexcept
+    {
+        for (Item& item : items)
+            lookup(item.id, item.bounds);
+        refit_nodes();
+    }
+
+    // True once refits have made the boxes notably larger than a fresh build
+    bool needs_rebuild() const noexcept { return area > 2.0f * built_area; }
+
+    // Call emit(id) for every item whose bounds satisfy visible(bounds)
+    template <typename Visible, typename Emit>
+    void query(Visible&& visible, Emit&& emit) const noexcept
+    {
+        if (nodes.empty())
+            return;
+
+        std::array<std::uint32_t, 64> stack;
+        std::size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = nodes[stack[--top]];
+            if (!visible(node.bounds))
+                continue;
+
+            if (node.count > 0)
+            {
+                for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+                {
+                    if (visible(items[i].bounds))
+                        emit(items[i].id);
+                }
+                continue;
+            }
+
+            // Left child follows its parent; `first` is the right child
+            stack[top++] = node.first;
+            stack[top++] = static_cast<std::uint32_t>(&node - nodes.data()) + 1;
+        }
+    }
+
+    std::size_t get_item_count() const noexcept { return items.size(); }
+
+    std::size_t get_node_count() const noexcept { return nodes.size(); }
+
+private:
+    struct Node
+    {
+        Bounds bounds;
+        // Leaf: items [first, first + count). Inner node (count == 0):
+        // `first` is the right child, the left one is the next node.
+        std::uint32_t first{0};
+        std::uint32_t count{0};
+    };
+
+    std::uint32_t build_node(std::uint32_t first, std::uint32_t count, unsigned depth) noexcept;
+
+    void refit_nodes() noexcept;
+
+    // Fit `node` around its items or children
+    void fit(Node& node) noexcept;
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+    // Summed surface area of all boxes, after the last build and now
+    float built_area{0.0f};
+    float area{0.0f};
+};
@@ -28,6 +28,9 @@ public:
 
     void update(GLfloat dt) noexcept;
 
+    // Jump to a fixed position and orientation (degrees), e.g. for scripted views
+    void set_pose(const glm::vec3& _position, GLfloat _pitch, GLfloat _yaw) noexcept;
+
     glm::mat4 get_view_matrix() const noexcept;
 
     glm::vec3 get_position() const noexcept { return position; }
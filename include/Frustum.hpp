@@ -1,13 +1,61 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include <glm/glm.hpp>
 
+// Bounds stored one coordinate array per component (SoA), so a batched test
+// loads the same component of 4 objects at once. The arrays are padded to a
+// multiple of 4; padding entries are never reported.
+struct AABBArrays {
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    std::size_t count = 0;
+
+    void clear();
+    void push(const glm::vec3& min, const glm::vec3& max);
+};
+
+struct SphereArrays {
+    std::vector<float> x, y, z, radius;
+    std::size_t count = 0;
+
+    void clear();
+    void push(const glm::vec3& center, float radius);
+};
+
 class Frustum {
 public:
     void update(const glm::mat4& viewProjMatrix);
     bool isSphereInFrustum(const glm::vec3& center, float radius) const;
+    // Scalar reference for cullAABBs
     bool isAABBInFrustum(const glm::vec3& min, const glm::vec3& max) const;
-    
+
+    // Batched tests, 4 objects per iteration with SSE: `visible` receives
+    // the indices of the objects inside, in ascending order. `hints`, if
+    // given, keeps per group of 4 the plane that last rejected the whole
+    // group; it is tried first next time, so groups that stay outside
+    // between frames are usually rejected by a single plane.
+    void cullAABBs(const AABBArrays& bounds, std::vector<std::uint32_t>& visible, std::vector<std::uint8_t>* hints = nullptr) const;
+    void cullSpheres(const SphereArrays& bounds, std::vector<std::uint32_t>& visible, std::vector<std::uint8_t>* hints = nullptr) const;
+
 private:
     glm::vec4 planes[6];
-};
\ No newline at end of file
+};
+
+// Bounding cone of a spot light: apex at the light, opening along `axis`
+// (normalized) with the given half angle, cut off at `range`. The sine and
+// cosine of the half angle are kept so the sphere test needs no acos.
+class Cone {
+public:
+    void update(const glm::vec3& apex, const glm::vec3& axis, float halfAngleRadians, float range);
+    bool isSphereInCone(const glm::vec3& center, float radius) const;
+
+private:
+    glm::vec3 apex{0.0f};
+    glm::vec3 axis{0.0f, -1.0f, 0.0f};
+    float sinAngle{0.0f};
+    float cosAngle{1.0f};
+    float range{0.0f};
+};
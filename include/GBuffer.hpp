@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Geometry buffer of the deferred path: the scene is drawn once into it
+// (gbuffer.frag) and lit afterwards in a single screen-space pass
+// (deferred_lighting.frag), so every light is evaluated once per visible
+// pixel however much geometry overlaps.
+//
+//   0: RGBA8   albedo, shininess / 256 in alpha
+//   1: RGBA16F world-space normal (after normal mapping), flags in w
+//   depth: 24-bit depth, from which the lighting pass rebuilds the position
+class GBuffer
+{
+public:
+    GBuffer(GLsizei _width, GLsizei _height) noexcept;
+
+    GBuffer(const GBuffer& gbuffer) = delete;
+
+    GBuffer(GBuffer&& gbuffer) = delete;
+
+    ~GBuffer();
+
+    GBuffer& operator = (const GBuffer& gbuffer) = delete;
+
+    GBuffer& operator = (GBuffer&& gbuffer) = delete;
+
+    // Reallocate the attachments if the size changed
+    void resize(GLsizei _width, GLsizei _height) noexcept;
+
+    // Bind the FBO and clear it, ready for the geometry pass
+    void begin() const noexcept;
+
+    // Albedo, normal and depth on `first_unit` and the next two units
+    void bind_textures(GLuint first_unit) const noexcept;
+
+    GLsizei get_width() const noexcept { return width; }
+
+    GLsizei get_height() const noexcept { return height; }
+
+private:
+    void allocate() noexcept;
+
+    GLsizei width;
+    GLsizei height;
+    GLuint fbo{0};
+    GLuint albedo{0};
+    GLuint normal{0};
+    GLuint depth{0};
+};
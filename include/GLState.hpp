@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL bindings the renderer changes most often: the
+// current program, vertex array, framebuffer and the 2D/cube/buffer texture
+// bound to each unit. Every bind goes through here and is only forwarded to
+// the driver when it changes something. Code that binds these objects
+// directly, or deletes them, must keep the cache in sync (see the forget_*
+// calls).
+class GLState
+{
+public:
+    // Texture units tracked; GL guarantees at least 16 for fragment shaders
+    static constexpr GLuint MAX_TEXTURE_UNITS = 16;
+
+    GLState() = delete;
+
+    static void use_program(GLuint program) noexcept;
+
+    static void bind_vertex_array(GLuint vertex_array) noexcept;
+
+    // Binds to GL_FRAMEBUFFER (draw and read)
+    static void bind_framebuffer(GLuint framebuffer) noexcept;
+
+    // `target` is GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_BUFFER.
+    // Selects the unit first, also only when needed.
+    static void bind_texture(GLuint unit, GLenum target, GLuint texture) noexcept;
+
+    // Drop cached references to objects that are about to be deleted, since
+    // GL may hand the same name out again
+    static void forget_program(GLuint program) noexcept;
+
+    static void forget_vertex_array(GLuint vertex_array) noexcept;
+
+    static void forget_framebuffer(GLuint framebuffer) noexcept;
+
+    static void forget_texture(GLuint texture) noexcept;
+
+    // Forget everything, e.g. after code outside the cache touched bindings
+    static void invalidate() noexcept;
+
+    // State changes forwarded to the driver, and binds skipped because they
+    // matched the cache, since the last reset
+    static std::size_t get_issued() noexcept { return issued; }
+
+    static std::size_t get_skipped() noexcept { return skipped; }
+
+    static void reset_counters() noexcept;
+
+private:
+    // Names no object can have, so the first bind after invalidate() is
+    // always issued
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    static GLuint program;
+    static GLuint vertex_array;
+    static GLuint framebuffer;
+    static GLuint active_unit;
+    static std::array<GLuint, MAX_TEXTURE_UNITS> textures_2d;
+    static std::array<GLuint, MAX_TEXTURE_UNITS> textures_cube;
+    static std::array<GLuint, MAX_TEXTURE_UNITS> textures_buffer;
+
+    static std::size_t issued;
+    static std::size_t skipped;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <GL/glew.h>
+
+// GL query (samples passed, time elapsed...) issued around the same work
+// every frame. Results are read a few frames late, once the GPU has them, so
+// measuring never stalls the pipeline; get_result() is the latest one read.
+class GpuQuery
+{
+public:
+    // Frames a query may stay in flight before its slot is needed again
+    static constexpr std::size_t LATENCY = 3;
+
+    // `target` is any single-value query target, e.g. GL_SAMPLES_PASSED or
+    // GL_TIME_ELAPSED
+    explicit GpuQuery(GLenum _target) noexcept;
+
+    GpuQuery(const GpuQuery& query) = delete;
+
+    GpuQuery(GpuQuery&& query) = delete;
+
+    ~GpuQuery();
+
+    GpuQuery& operator = (const GpuQuery& query) = delete;
+
+    GpuQuery& operator = (GpuQuery&& query) = delete;
+
+    // Only one query per target can be active at a time
+    void begin() noexcept;
+
+    void end() noexcept;
+
+    // Latest result available, 0 before the first one arrives
+    std::uint64_t get_result() const noexcept { return result; }
+
+    // Sum and number of the results read since the last reset_totals(), for
+    // averages over many frames
+    std::uint64_t get_total() const noexcept { return total; }
+
+    std::size_t get_count() const noexcept { return count; }
+
+    void reset_totals() noexcept;
+
+private:
+    // Read every finished query, oldest first
+    void collect() noexcept;
+
+    GLenum target;
+    std::array<GLuint, LATENCY> ids{};
+    std::array<bool, LATENCY> pending{};
+    std::size_t next{0};
+    // Slot begun this frame, or LATENCY if it was still in flight
+    std::size_t active{LATENCY};
+    std::uint64_t result{0};
+    std::uint64_t total{0};
+    std::size_t count{0};
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Streaming buffer of per-instance transforms. Instances are appended to a
+// ring and read by instanced draws through attribute locations 4-10 with a
+// divisor of 1. When the ring is full its storage is orphaned, so a write
+// never waits on data the GPU may still be reading.
+class InstanceBuffer
+{
+public:
+    // First of the four vec4 attribute locations holding the matrix columns
+    static constexpr GLuint ATTRIBUTE_LOCATION = 4;
+
+    // First of the three holding the normal matrix columns
+    static constexpr GLuint NORMAL_ATTRIBUTE_LOCATION = 8;
+
+    // One instance as the vertex shaders read it. The normal matrix is
+    // computed here once rather than per vertex; its columns are padded to
+    // vec4 and the shader reads their xyz.
+    struct Instance
+    {
+        glm::mat4 model{1.0f};
+        glm::vec4 normal[3]{};
+
+        Instance() = default;
+
+        explicit Instance(const glm::mat4& _model) noexcept;
+    };
+
+    explicit InstanceBuffer(std::size_t capacity = 4096) noexcept;
+
+    InstanceBuffer(const InstanceBuffer& buffer) = delete;
+
+    InstanceBuffer(InstanceBuffer&& buffer) = delete;
+
+    ~InstanceBuffer();
+
+    InstanceBuffer& operator = (const InstanceBuffer& buffer) = delete;
+
+    InstanceBuffer& operator = (InstanceBuffer&& buffer) = delete;
+
+    // Copy `count` instances into the ring and return the index of the
+    // first one, to be passed to Mesh::render_instanced.
+    std::size_t write(const Instance* instances, std::size_t count) noexcept;
+
+    GLuint get_id() const noexcept { return buffer_id; }
+
+    std::size_t get_capacity() const noexcept { return capacity; }
+
+private:
+    void allocate(std::size_t new_capacity) noexcept;
+
+    GLuint buffer_id{0};
+    std::size_t capacity{0};
+    std::size_t cursor{0};
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <UniformBlocks.hpp>
+
+// Clustered light assignment. The camera frustum is cut into a grid of
+// screen tiles and exponentially spaced depth slices (froxels); every frame
+// each point and spot light is tested against the clusters its volume can
+// touch, and the per-cluster index lists are uploaded with the lights to
+// buffer textures. A fragment finds its cluster from its window position and
+// view depth and only walks that cluster's lights, so its cost follows the
+// lights around it rather than the lights in the scene.
+//
+// Built on the CPU: GL 4.1 has no compute shaders or storage buffers, so
+// the lists reach the shader through three texture buffers (see bind()).
+class LightClusters
+{
+public:
+    // Light contributions below this are dropped, which is what bounds a
+    // light's range (one step of an 8-bit channel)
+    static constexpr float CUTOFF = 1.0f / 256.0f;
+
+    // Every light is stored as a SpotLightData: seven RGBA32F texels
+    static constexpr std::size_t TEXELS_PER_LIGHT = sizeof(SpotLightData) / sizeof(glm::vec4);
+
+    // Indices are 16-bit
+    static constexpr std::size_t MAX_LIGHTS = 65535;
+
+    LightClusters(unsigned _tiles_x, unsigned _tiles_y, unsigned _slices) noexcept;
+
+    LightClusters(const LightClusters& clusters) = delete;
+
+    LightClusters(LightClusters&& clusters) = delete;
+
+    ~LightClusters();
+
+    LightClusters& operator = (const LightClusters& clusters) = delete;
+
+    LightClusters& operator = (LightClusters&& clusters) = delete;
+
+    // Distance at which the brightest channel of a light, fading with the
+    // (constant, linear, quadratic) `attenuation`, falls below CUTOFF
+    static float effective_range(const glm::vec4& attenuation, float peak) noexcept;
+
+    // Remove every light; the list is rebuilt each frame
+    void clear() noexcept;
+
+    // `shadow` is the light's shadow map: 0 for the point shadow cubemap, the
+    // ShadowsBlock slot for a spot, or -1 for none. Returns false once
+    // MAX_LIGHTS is reached.
+    bool add(const PointLightData& light, int shadow = -1) noexcept;
+
+    bool add(const SpotLightData& light, int shadow = -1) noexcept;
+
+    // Assign the lights to the clusters of this view and upload everything.
+    // `projection` must be a perspective matrix; its near and far planes
+    // bound the slices. `width` and `height` are the viewport's, in pixels.
+    void update(const glm::mat4& view, const glm::mat4& projection, GLsizei width, GLsizei height) noexcept;
+
+    // Grid size and the fragment to cluster mapping for the Lights block
+    void write(LightsBlock& block) const noexcept;
+
+    // Bind the light data, the cluster table (offset and count into the
+    // index list) and the index list to `first_unit` and the next two units
+    void bind(GLuint first_unit) const noexcept;
+
+    std::size_t get_light_count() const noexcept { return lights.size(); }
+
+    std::size_t get_cluster_count() const noexcept { return cluster_count; }
+
+    // Light references over all clusters, clusters with at least one light,
+    // and the longest list, after the last update()
+    std::size_t get_reference_count() const noexcept { return indices.size(); }
+
+    std::size_t get_occupied_clusters() const noexcept { return occupied; }
+
+    std::size_t get_max_cluster_lights() const noexcept { return max_cluster_lights; }
+
+private:
+    // World-space culling shape of a light: a sphere, or a cone if `spot`
+    struct Volume
+    {
+        glm::vec3 position{0.0f};
+        float range{0.0f};
+        glm::vec3 direction{0.0f};
+        float cos_angle{-1.0f};
+        bool spot{false};
+    };
+
+    struct Box
+    {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+    };
+
+    bool push(const SpotLightData& light, bool spot, int shadow) noexcept;
+
+    // Recompute the view-space box of every cluster for `projection`
+    void build_grid(const glm::mat4& projection) noexcept;
+
+    int slice_of(float depth) const noexcept;
+
+    void upload(GLuint buffer, const void* data, std::size_t size) const noexcept;
+
+    unsigned tiles_x;
+    unsigned tiles_y;
+    unsigned slices;
+    std::size_t cluster_count;
+
+    std::vector<SpotLightData> lights;
+    std::vector<Volume> volumes;
+
+    // View-space bounds of each cluster, for the current projection
+    glm::mat4 grid_projection{0.0f};
+    float near_plane{0.0f};
+    float far_plane{0.0f};
+    float slice_scale{0.0f};
+    float slice_bias{0.0f};
+    glm::vec2 tiles_per_pixel{0.0f};
+    std::vector<Box> boxes;
+    std::vector<glm::vec4> spheres;
+
+    // Per cluster: offset and count into `indices`
+    std::vector<std::uint32_t> table;
+    std::vector<std::uint16_t> indices;
+    // Scratch: (cluster, light) pairs in light order
+    std::vector<std::uint32_t> pairs;
+    std::size_t occupied{0};
+    std::size_t max_cluster_lights{0};
+
+    GLuint light_buffer{0};
+    GLuint table_buffer{0};
+    GLuint index_buffer{0};
+    GLuint light_texture{0};
+    GLuint table_texture{0};
+    GLuint index_texture{0};
+};
@@ -16,7 +16,7 @@ public:
     Lightbulb(const PointLight& light, const glm::vec3& color);
 
     void render(const std::shared_ptr<Shader>& shader) const;
-    void use_light(const std::shared_ptr<Shader>& shader, GLuint light_index) const;
+    void write_light(PointLightData& data) const;
     void set_position(const glm::vec3& p);
 
     static void create_mesh();
@@ -1,16 +1,55 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
 #include <vector>
 
 #include <GL/glew.h>
 
+class InstanceBuffer;
+
 class Mesh
 {
 public:
+    // GPU vertex layout of a mesh. Both keep attribute locations 0-3 as
+    // position, normal, uv, tangent so every shader works with either.
+    enum class VertexFormat
+    {
+        FLOAT,  // 44 bytes: float pos(3), normal(3), uv(2), tangent(3)
+        PACKED  // 24 bytes: float pos(3), 10_10_10_2 normal, half uv(2), 10_10_10_2 tangent
+    };
+
+    struct PackedVertex
+    {
+        GLfloat position[3];
+        GLuint normal;  // GL_INT_2_10_10_10_REV, normalized
+        GLuint uv;      // two GL_HALF_FLOAT
+        GLuint tangent; // GL_INT_2_10_10_10_REV, normalized
+    };
+
     Mesh() = default;
 
-    static std::shared_ptr<Mesh> create(const std::vector<GLfloat>& vertices, std::vector<unsigned int> indices) noexcept;
+    static std::shared_ptr<Mesh> create(const std::vector<GLfloat>& vertices, std::vector<unsigned int> indices, VertexFormat format = VertexFormat::FLOAT) noexcept;
+
+    // CPU-only half of create(): takes pos(3), normal(3), uv(2) vertices and
+    // returns the final interleaved stream with a tangent(3) appended to each
+    // vertex. Touches no GL state, so it can run on worker threads.
+    static std::vector<GLfloat> build_vertices(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices) noexcept;
+
+    // Quantize an 11-float stream from build_vertices into PackedVertex.
+    // CPU-only, like build_vertices.
+    static std::vector<PackedVertex> pack_vertices(const GLfloat* vertex_data, std::size_t vertex_count) noexcept;
+
+    // Half floats lose texel precision quickly past |uv| = 2, so heavily
+    // tiled meshes should stay in FLOAT.
+    static bool can_pack(const GLfloat* vertex_data, std::size_t vertex_count) noexcept;
+
+    static std::size_t get_vertex_size(VertexFormat format) noexcept;
+
+    // GL half of create(): uploads an already built vertex stream in the
+    // given format (11 floats or PackedVertex per vertex). Must be called on
+    // the thread that owns the GL context.
+    static std::shared_ptr<Mesh> upload(VertexFormat format, const void* vertex_data, std::size_t vertex_count, const unsigned int* index_data, std::size_t index_count) noexcept;
 
     Mesh(const Mesh& mesh) = delete;
 
@@ -23,12 +62,41 @@ public:
     Mesh& operator = (Mesh&& mesh) = delete;
 
     void render() const noexcept;
+
+    // Draw through the position-only stream. Depth-only passes read nothing
+    // but location 0, so they fetch 12 bytes per vertex instead of the full
+    // vertex.
+    void render_depth() const noexcept;
+
+    // Draw `count` instances whose transforms start at index `first` in
+    // `instances`, in one glDrawElementsInstanced call.
+    void render_instanced(const InstanceBuffer& instances, std::size_t first, GLsizei count) const noexcept;
+
+    // Instanced variant of render_depth()
+    void render_depth_instanced(const InstanceBuffer& instances, std::size_t first, GLsizei count) const noexcept;
+
+    VertexFormat get_format() const noexcept { return format; }
+
+    // Size of the vertex buffer in bytes: positions and other attributes,
+    // each stored once
+    std::size_t get_vertex_bytes() const noexcept { return vertex_bytes; }
     
 private:
     void clear() noexcept;
 
+    // Point attributes 4-7 of the bound VAO at the instance matrices, and
+    // 8-10 at their normal matrices if `normals` is set (depth passes have
+    // no use for them). There is no base-instance draw in GL 4.1, so the
+    // offset goes in the pointer.
+    static void bind_instances(const InstanceBuffer& instances, std::size_t first, bool normals) noexcept;
+
     GLuint VAO_id{0};
     GLuint VBO_id{0};
     GLuint IBO_id{0};
+    // VBO_id holds every position (12 bytes each) first, then the other
+    // attributes interleaved; depth_VAO_id reads only the positions
+    GLuint depth_VAO_id{0};
     GLsizei index_count{0};
+    VertexFormat format{VertexFormat::FLOAT};
+    std::size_t vertex_bytes{0};
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include <AssimpLoader.hpp>
+
+// Read-only memory mapping of a whole file. The mapping is released when the
+// last shared owner goes away.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile& file) = delete;
+
+    MappedFile(MappedFile&& file) = delete;
+
+    ~MappedFile();
+
+    MappedFile& operator = (const MappedFile& file) = delete;
+
+    MappedFile& operator = (MappedFile&& file) = delete;
+
+    static std::shared_ptr<MappedFile> open(const std::filesystem::path& file_path) noexcept;
+
+    const std::byte* get_data() const noexcept { return data; }
+
+    std::size_t get_size() const noexcept { return size; }
+
+private:
+    const std::byte* data{nullptr};
+    std::size_t size{0};
+};
+
+// Versioned binary cache of imported models ("cooked meshes"). Each source
+// model gets one file holding the final vertex streams (float or packed), index
+// buffers, per-renderable transforms, source bounds and texture references,
+// so warm starts skip Assimp entirely. A content hash of the source (and of
+// the buffers a glTF references) is checked on every read.
+class MeshCache
+{
+public:
+    // Bump whenever the file layout or the meaning of the stored streams changes
+    static constexpr std::uint32_t FORMAT_VERSION = 2;
+
+    MeshCache() = delete;
+
+    // Directory where cooked files are stored. Caching is disabled while it
+    // is empty.
+    static void set_directory(const std::filesystem::path& directory) noexcept;
+
+    static const std::filesystem::path& get_directory() noexcept { return directory; }
+
+    // Fill `model` from the cooked file for `source`. Returns false (leaving
+    // `model` untouched) when there is no cooked file or it is stale/corrupt.
+    // On success the meshes reference the mapped file directly.
+    static bool read(const std::filesystem::path& source, AssimpLoader::ModelData& model) noexcept;
+
+    // Write the cooked file for `source`. Returns false on I/O errors.
+    static bool write(const std::filesystem::path& source, const AssimpLoader::ModelData& model) noexcept;
+
+    // Path of the cooked file for `source` inside the cache directory
+    static std::filesystem::path get_cooked_path(const std::filesystem::path& source) noexcept;
+
+    // FNV-1a hash of the source file plus any external .bin buffers it references
+    static std::uint64_t hash_source(const std::filesystem::path& source) noexcept;
+
+private:
+    static std::filesystem::path directory;
+};
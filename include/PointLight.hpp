@@ -1,11 +1,9 @@
 #pragma once
 
-#include <memory>
-
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
-#include <Shader.hpp>
+#include <UniformBlocks.hpp>
 
 class PointLight
 {
@@ -18,7 +16,8 @@ public:
                GLfloat _linear,
                GLfloat _quadratic) noexcept;
 
-    void use(const std::shared_ptr<Shader>& shader, GLuint light_index) const noexcept;
+    // Fill this light's entry of the Lights uniform block
+    void write(PointLightData& data) const noexcept;
 
     glm::vec3 get_position() const noexcept { return position; }
     void set_position(const glm::vec3& p) noexcept { position = p; }
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Frustum.hpp>
+
+// Cells and portals built from the rooms' door masks. Every room is a cell
+// (its bounding box); two rooms whose doors meet are linked by a portal, and
+// doors leading nowhere link to one extra "outside" cell. Each frame
+// update() walks the graph from the camera's cell, narrowing the view to the
+// screen rectangle of every doorway it passes, so a cell is visible only
+// through the chain of doors that leads to it. The cost is proportional to
+// the portals actually seen, not to the number of rooms.
+class PortalGraph
+{
+public:
+    PortalGraph() = default;
+
+    PortalGraph(const PortalGraph& graph) = delete;
+
+    PortalGraph(PortalGraph&& graph) = delete;
+
+    PortalGraph& operator = (const PortalGraph& graph) = delete;
+
+    PortalGraph& operator = (PortalGraph&& graph) = delete;
+
+    // Add a room placed with `transform` (a translation, as rooms are laid
+    // out on a grid) and the given Room::DoorSide mask. Returns its cell.
+    std::size_t add_room(const glm::mat4& transform, int door_mask) noexcept;
+
+    // Link the doors of all rooms added so far. Call once after the last
+    // add_room().
+    void build() noexcept;
+
+    // Compute what the camera sees this frame
+    void update(const glm::mat4& view_projection, const glm::vec3& eye) noexcept;
+
+    // The room containing `point`, or outside()
+    std::size_t locate(const glm::vec3& point) const noexcept;
+
+    std::size_t outside() const noexcept { return cells.size() - 1; }
+
+    // Whether anything of `cell` is seen this frame
+    bool is_visible(std::size_t cell) const noexcept { return cells[cell].visible; }
+
+    // A room is also seen from the outside (its walls) when it lies in the
+    // part of the view that reaches the outside cell
+    bool is_room_visible(std::size_t cell) const noexcept;
+
+    // Box test for the contents of the rooms: passes if the box is in the
+    // visible part of any cell it overlaps
+    bool is_box_visible(const glm::vec3& min, const glm::vec3& max) const noexcept;
+
+    std::size_t get_cell_count() const noexcept { return cells.size(); }
+
+    std::size_t get_portal_count() const noexcept { return portals.size(); }
+
+    // Cells reached and portals clipped by the last update()
+    std::size_t get_visible_cells() const noexcept { return reached.size(); }
+
+    std::size_t get_portals_tested() const noexcept { return portals_tested; }
+
+private:
+    // Screen rectangle in normalized device coordinates
+    struct Rect
+    {
+        glm::vec2 min{-1.0f};
+        glm::vec2 max{1.0f};
+    };
+
+    struct Cell
+    {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+        std::vector<std::size_t> portals;
+
+        // Per frame: union of the rectangles the cell was reached through,
+        // and the camera frustum cropped to it
+        bool visible{false};
+        Rect rect;
+        Frustum frustum;
+    };
+
+    struct Door
+    {
+        std::size_t cell;
+        glm::vec3 center;
+        // Outward normal of the wall the door is in
+        glm::vec3 normal;
+    };
+
+    struct Portal
+    {
+        std::array<glm::vec3, 4> corners;
+        glm::vec3 center{0.0f};
+        // Unit normal pointing from cells[0] into cells[1]
+        glm::vec3 normal{0.0f};
+        std::array<std::size_t, 2> cells{0, 0};
+    };
+
+    void visit(std::size_t cell, std::size_t from_portal, const Rect& rect, unsigned depth) noexcept;
+
+    // Screen rectangle of `portal`, clipped against the near plane. False
+    // if the portal is entirely behind the camera.
+    bool project(const Portal& portal, Rect& rect) const noexcept;
+
+    std::vector<Cell> cells{Cell{}};
+    std::vector<Door> doors;
+    std::vector<Portal> portals;
+
+    glm::mat4 view_projection{1.0f};
+    glm::vec3 eye{0.0f};
+    // Cells reached this frame, so the next update() only resets those
+    std::vector<std::size_t> reached;
+    std::size_t portals_tested{0};
+};
@@ -6,6 +6,7 @@
 
 #include <glm/glm.hpp>
 
+#include <Bounds.hpp>
 #include <Mesh.hpp>
 #include <Texture.hpp>
 #include <Shader.hpp>
@@ -23,6 +24,16 @@ public:
         DOOR_RIGHT = 1 << 3  // +X
     };
 
+    // Room-space dimensions: a square room centered on the origin, with
+    // doors centered on their wall and standing on the floor
+    static constexpr float HALF_EXTENT = 10.0f;
+    static constexpr float FLOOR_Y = -2.0f;
+    static constexpr float CEILING_Y = 8.0f;
+    static constexpr float DOOR_WIDTH = 4.0f;
+    static constexpr float DOOR_HEIGHT = 6.0f;
+    // Walls are thin boxes centered on the room's sides
+    static constexpr float WALL_THICKNESS = 0.08f;
+
     // root_path: directory where textures/ live. door_mask: bitmask of DoorSide
     Room(const std::filesystem::path &root_path, int door_mask = DOOR_NONE);
     ~Room() = default;
@@ -32,8 +43,17 @@ public:
     void render(const std::shared_ptr<Shader> &shader, const glm::mat4 &model);
     // Render only the geometry that should contribute to shadow maps.
     void render_for_depth(const std::shared_ptr<Shader> &shader, const glm::mat4 &model);
+    // Render the positions of everything render() draws, back faces
+    // included, for the camera's depth prepass.
+    void render_depth(const std::shared_ptr<Shader> &shader, const glm::mat4 &model);
+
+    int get_door_mask() const noexcept { return door_mask; }
+
+    // World bounds of a room rendered with `model`, walls included
+    static Bounds bounds(const glm::mat4 &model) noexcept;
 
 private:
+    int door_mask{DOOR_NONE};
     std::shared_ptr<Mesh> floor_mesh;
     // Each side (or panel) is represented by a Wall so we can render them
     // individually. `walls` holds geometry rendered in the main pass;
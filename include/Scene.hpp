@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <AssimpLoader.hpp>
+#include <Bounds.hpp>
+#include <Bvh.hpp>
+#include <Frustum.hpp>
+#include <InstanceBuffer.hpp>
+#include <Shader.hpp>
+
+// Registry of every placed model instance. Placements are registered once at
+// load time; build() then lays instances out contiguously per model and bakes
+// the world and normal matrices of every (instance, part) pair, so passes only cull and
+// draw. A culled VisibleSet can be shared and narrowed by several passes.
+// Culling walks a BVH over the instance bounds (one for static instances,
+// one for dynamic ones, which is refit as they move), so its cost follows
+// what is visible rather than the size of the scene.
+class Scene
+{
+public:
+    using ModelId = std::size_t;
+
+    // One drawable part of a model and its transform relative to the instance
+    struct Part
+    {
+        AssimpLoader::Renderable renderable;
+        glm::mat4 local{1.0f};
+    };
+
+    struct Instance
+    {
+        ModelId model;
+        glm::mat4 placement;
+        // World bounds of every part, from the parts' source bounds
+        Bounds bounds;
+        // Dynamic instances may move after build(); shadow maps keep them
+        // out of their cached static layer
+        bool dynamic{false};
+    };
+
+    // Space touched by a moved instance: its bounds before or after the move
+    using Change = Bounds;
+
+    // Indices of visible instances in ascending order (hence grouped by
+    // model). Keep one per pass alive across frames to avoid reallocations.
+    struct VisibleSet
+    {
+        std::vector<std::uint32_t> instances;
+    };
+
+    Scene() = default;
+
+    Scene(const Scene& scene) = delete;
+
+    Scene(Scene&& scene) = delete;
+
+    Scene& operator = (const Scene& scene) = delete;
+
+    Scene& operator = (Scene&& scene) = delete;
+
+    // Register a model whose parts keep their imported transforms
+    ModelId add_model(const std::vector<AssimpLoader::Renderable>& renderables) noexcept;
+
+    // Register a model with explicit per-part local transforms
+    ModelId add_model(std::vector<Part> parts) noexcept;
+
+    // Place `model` in the world. Its bounds are computed from the source
+    // bounds of the model's parts under `placement`.
+    void add_instance(ModelId model, const glm::mat4& placement, bool dynamic = false) noexcept;
+
+    // Move a dynamic instance (index into get_instances()) after build().
+    // Its bounds follow, and the old and new ones are recorded as changes.
+    void set_placement(std::size_t instance, const glm::mat4& placement) noexcept;
+
+    // Sort instances by model and bake the world and normal matrices. Call once after
+    // the last add_instance.
+    void build() noexcept;
+
+    // Fill `out` with every instance for which visible(bounds) holds. The
+    // predicate is also applied to BVH node bounds, so it must hold for any
+    // bounds enclosing ones it holds for (true of frustum, range and cone
+    // tests).
+    template <typename Visible>
+    void cull(Visible&& visible, VisibleSet& out) const noexcept
+    {
+        out.instances.clear();
+        query(static_bvh, visible, out);
+        query(dynamic_bvh, visible, out);
+        std::sort(out.instances.begin(), out.instances.end());
+    }
+
+    // Same, restricted to static or to dynamic instances
+    template <typename Visible>
+    void cull(bool dynamic, Visible&& visible, VisibleSet& out) const noexcept
+    {
+        out.instances.clear();
+        query(dynamic ? dynamic_bvh : static_bvh, visible, out);
+        std::sort(out.instances.begin(), out.instances.end());
+    }
+
+    // True if any change since the last clear_changes() satisfies touches(bounds)
+    template <typename Touches>
+    bool changed(Touches&& touches) const noexcept
+    {
+        for (const auto& change : changes)
+        {
+            if (touches(change))
+                return true;
+        }
+        return false;
+    }
+
+    void clear_changes() noexcept { changes.clear(); }
+
+    // Narrow an already culled set, e.g. camera-visible instances to those in a light's range
+    template <typename Visible>
+    void filter(const VisibleSet& in, Visible&& visible, VisibleSet& out) const noexcept
+    {
+        out.instances.clear();
+        for (std::uint32_t i : in.instances)
+        {
+            if (visible(instances[i].bounds))
+                out.instances.push_back(i);
+        }
+    }
+
+    // Boxes of the instances in `set`, in its order, as SoA arrays for the
+    // batched Frustum::cullAABBs. Gather once to test a set against several
+    // frusta, e.g. the six faces of a cubemap.
+    void gather_bounds(const VisibleSet& set, AABBArrays& out) const noexcept;
+
+    // Keep the entries of `in` at `positions`: ascending indices into
+    // in.instances, as cullAABBs returns for the bounds gathered from `in`
+    void select(const VisibleSet& in, const std::vector<std::uint32_t>& positions, VisibleSet& out) const noexcept;
+
+    // Draw the visible instances with one instanced call per model part.
+    // `shader` must be bound; depth passes bind no textures and use the
+    // position-only stream. When `flat_shader` is given (a variant without
+    // normal mapping, set up like `shader`), parts without a normal map are
+    // drawn with it after the others, so the program switches once.
+    void draw(const VisibleSet& visible, const std::shared_ptr<Shader>& shader, bool depth_only,
+              const std::shared_ptr<Shader>& flat_shader = nullptr) noexcept;
+
+    const std::vector<Instance>& get_instances() const noexcept { return instances; }
+
+private:
+    template <typename Visible>
+    void query(const Bvh& bvh, Visible&& visible, VisibleSet& out) const noexcept
+    {
+        if (&bvh == &dynamic_bvh)
+            refit_dynamic();
+        bvh.query(visible, [&](std::uint32_t i) { out.instances.push_back(i); });
+    }
+
+    Bounds instance_bounds(ModelId model, const glm::mat4& placement) const noexcept;
+
+    // Bring the dynamic BVH up to date with set_placement() calls, and
+    // rebuild it when refitting has loosened it too much
+    void refit_dynamic() const noexcept;
+
+    struct Model
+    {
+        std::vector<Part> parts;
+        std::size_t first_instance{0};
+        std::size_t instance_count{0};
+        // world[first_world + part * instance_count + k] is part `part` of
+        // the model's k-th instance
+        std::size_t first_world{0};
+    };
+
+    std::vector<Model> models;
+    std::vector<Instance> instances;
+    std::vector<InstanceBuffer::Instance> world;
+    std::vector<InstanceBuffer::Instance> scratch;
+    std::vector<Change> changes;
+    Bvh static_bvh;
+    // Refit lazily by the first cull after instances moved
+    mutable Bvh dynamic_bvh;
+    mutable bool dynamic_moved{false};
+    std::unique_ptr<InstanceBuffer> instance_buffer;
+};
@@ -1,14 +1,24 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 
 #include <BSlogger.hpp>
 
+// Preprocessor definitions a program is specialized with. Each entry is
+// "NAME" or "NAME VALUE" and becomes a #define right after the #version line
+// of every stage, so one source yields several variants (see ShaderCache).
+using ShaderDefines = std::vector<std::string>;
+
 class Shader
 {
 public:
@@ -28,6 +38,14 @@ public:
 
     static std::shared_ptr<Shader> create_from_files(std::filesystem::path vertex_shader_path, std::filesystem::path fragment_shader_path) noexcept;
 
+    // Same, specialized with `defines`
+    static std::shared_ptr<Shader> create_from_files(std::filesystem::path vertex_shader_path, std::filesystem::path fragment_shader_path, const ShaderDefines& defines) noexcept;
+
+    // Same, with a geometry stage between the vertex and fragment stages
+    static std::shared_ptr<Shader> create_from_strings(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept;
+
+    static std::shared_ptr<Shader> create_from_files(std::filesystem::path vertex_shader_path, std::filesystem::path geometry_shader_path, std::filesystem::path fragment_shader_path) noexcept;
+
     GLuint get_uniform_projection_id() const noexcept { return uniform_projection_id; }
 
     GLuint get_uniform_view_id() const noexcept { return uniform_view_id; }
@@ -38,22 +56,112 @@ public:
 
     GLuint get_uniform_texture_sampler_id() const noexcept { return uniform_texture_sampler_id; }
 
+    // Selects the per-instance matrix attribute over the `model` uniform
+    GLuint get_uniform_use_instancing_id() const noexcept { return uniform_use_instancing_id; }
+
     void use() const noexcept;
 
+    // Set the `model` uniform and, for programs that light (those declaring
+    // `normalMatrix`), the matching normal matrix. The program must be in use.
+    void set_model(const glm::mat4& model) const noexcept;
+
+    // FNV-1a hash of a uniform name, the key of the reflection table. It is
+    // constexpr so literal names can be hashed at compile time.
+    static constexpr std::uint64_t uniform_hash(std::string_view name, std::uint64_t hash = 14695981039346656037ull) noexcept
+    {
+        for (char c : name)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Location of an active uniform from the table reflected at link time,
+    // or -1 if the program has no such uniform. Never calls the driver.
+    GLint get_uniform_location(std::uint64_t name_hash) const noexcept;
+
+    GLint get_uniform_location(std::string_view name) const noexcept { return get_uniform_location(uniform_hash(name)); }
+
+    // Lookups answered by reflection tables, and glGetUniformLocation calls
+    // made (only at link time), since the last reset. Shared by all programs.
+    static std::size_t get_cached_lookups() noexcept { return cached_lookups; }
+
+    static std::size_t get_driver_lookups() noexcept { return driver_lookups; }
+
+    static void reset_lookup_counters() noexcept;
+
+    // Directory where linked programs are saved with glGetProgramBinary, keyed
+    // by their final sources (defines and includes expanded) and the driver,
+    // and loaded back with glProgramBinary on later runs. A binary the driver
+    // rejects is compiled again and replaced. Empty (the default) disables it.
+    static void set_binary_cache_directory(std::filesystem::path directory) noexcept;
+
+    // Programs loaded from the binary cache and programs compiled from
+    // source, and the milliseconds spent getting each kind linked
+    static std::size_t get_binary_hits() noexcept { return binary_hits; }
+
+    static std::size_t get_binary_misses() noexcept { return binary_misses; }
+
+    static double get_binary_hit_ms() noexcept { return binary_hit_ms; }
+
+    static double get_binary_miss_ms() noexcept { return binary_miss_ms; }
+
+    // Assign the named std140 block to a uniform buffer binding point and
+    // check its size against the CPU struct. Returns false if the program
+    // has no such block.
+    bool bind_uniform_block(const char* block_name, GLuint binding, std::size_t expected_size) const noexcept;
+
 private:
     void clear() noexcept;
 
-    void create_program(std::string_view vertex_shader_code, std::string_view fragment_shader_code) noexcept;
+    void create_program(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept;
+
+    // Compile the stages and link them; false if linking failed
+    bool link_program(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept;
 
     void create_shader(std::string_view shader_code, GLenum shader_type) noexcept;
 
-    static std::string read_file(const std::filesystem::path& shader_path) noexcept;
+    // Cache file of a program built from these sources by this driver, or an
+    // empty path if the cache is disabled or the driver cannot save programs
+    static std::filesystem::path binary_path(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept;
+
+    // Link the program from a cache file; false if it is missing, damaged or
+    // rejected by the driver
+    bool load_binary(const std::filesystem::path& path) noexcept;
+
+    void save_binary(const std::filesystem::path& path) const noexcept;
+
+    // Source of `shader_path`, with every `#include "file"` line replaced by
+    // that file (relative to the including one), so stages can share code
+    static std::string read_file(const std::filesystem::path& shader_path, unsigned depth = 0) noexcept;
+
+    // Insert `defines` after the #version line of `source`
+    static std::string specialize(const std::string& source, const ShaderDefines& defines) noexcept;
+
+    // Fill uniform_locations from the active uniforms of the linked program
+    void reflect_uniforms() noexcept;
+
+    GLint driver_location(const char* name) const noexcept;
+
+    std::unordered_map<std::uint64_t, GLint> uniform_locations;
+
+    static std::size_t cached_lookups;
+    static std::size_t driver_lookups;
+
+    static std::filesystem::path binary_cache_directory;
+    static std::size_t binary_hits;
+    static std::size_t binary_misses;
+    static double binary_hit_ms;
+    static double binary_miss_ms;
 
     GLuint program_id{0};
     GLuint uniform_projection_id{0};
     GLuint uniform_view_id{0};
     GLuint uniform_model_id{0};
     GLuint uniform_texture_sampler_id{0};
+    GLuint uniform_use_instancing_id{0};
+    GLint uniform_normal_matrix_id{-1};
 
     GLuint uniform_view_position_id{0};
     GLuint uniform_material_shininess_id{0};
@@ -62,3 +170,9 @@ private:
     GLuint uniform_light_diffuse_id{0};
     GLuint uniform_light_specular_id{0};
 };
+
+// Compile-time hashed uniform name: "material.shininess"_uniform
+constexpr std::uint64_t operator""_uniform(const char* name, std::size_t length) noexcept
+{
+    return Shader::uniform_hash(std::string_view{name, length});
+}
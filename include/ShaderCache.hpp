@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <Shader.hpp>
+
+// Process-wide registry of shader program variants, keyed by their source
+// files and the defines they are specialized with. Each variant is compiled
+// and linked once, when first requested; later requests for the same key get
+// the same program. Entries are weak, like TextureCache's, so a variant lives
+// as long as someone draws with it.
+class ShaderCache
+{
+public:
+    ShaderCache() = delete;
+
+    // The order of `defines` does not matter
+    static std::shared_ptr<Shader> get(const std::filesystem::path& vertex_shader_path, const std::filesystem::path& fragment_shader_path,
+                                       const ShaderDefines& defines = {}) noexcept;
+
+    static std::size_t get_hits() noexcept { return hits; }
+
+    static std::size_t get_misses() noexcept { return misses; }
+
+    // Number of variants currently alive in the registry
+    static std::size_t get_live_count() noexcept;
+
+private:
+    static std::string make_key(const std::filesystem::path& vertex_shader_path, const std::filesystem::path& fragment_shader_path,
+                                const ShaderDefines& defines) noexcept;
+
+    static std::unordered_map<std::string, std::weak_ptr<Shader>> entries;
+    static std::size_t hits;
+    static std::size_t misses;
+};
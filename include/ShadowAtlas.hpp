@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// One square depth texture shared by several 2D shadow maps. Each map owns a
+// square power-of-two tile whose side is chosen per light (near or large
+// lights get big tiles, far ones small), so a single sampler and a single
+// FBO serve every spot light.
+class ShadowAtlas
+{
+public:
+    struct Tile
+    {
+        GLint x{0};
+        GLint y{0};
+        GLsizei size{0};
+    };
+
+    // `size` and `min_tile` are powers of two; no tile is smaller than
+    // `min_tile` or larger than a quarter of the atlas
+    ShadowAtlas(GLsizei _size, GLsizei _min_tile) noexcept;
+
+    ShadowAtlas(const ShadowAtlas& atlas) = delete;
+
+    ShadowAtlas(ShadowAtlas&& atlas) = delete;
+
+    ~ShadowAtlas();
+
+    ShadowAtlas& operator = (const ShadowAtlas& atlas) = delete;
+
+    ShadowAtlas& operator = (ShadowAtlas&& atlas) = delete;
+
+    // Lay out one tile per entry of `requested` (desired sides, rounded down
+    // to powers of two and clamped). When they do not all fit, the largest
+    // tiles are halved until they do. Returns true if any tile moved or
+    // changed size, in which case the maps must be re-rendered.
+    bool pack(const std::vector<GLsizei>& requested) noexcept;
+
+    // Bind the atlas FBO and restrict viewport and scissor to `tile`,
+    // clearing the tile's depth if `clear` is set. end() lifts the scissor.
+    void begin(std::size_t tile, bool clear) const noexcept;
+
+    void end() const noexcept;
+
+    const Tile& get_tile(std::size_t tile) const noexcept { return tiles[tile]; }
+
+    // Tile as an atlas uv rectangle: offset in xy, scale in zw
+    glm::vec4 get_rect(std::size_t tile) const noexcept;
+
+    std::size_t get_tile_count() const noexcept { return tiles.size(); }
+
+    GLuint get_texture_id() const noexcept { return texture; }
+
+    GLsizei get_size() const noexcept { return size; }
+
+    GLsizei get_max_tile() const noexcept { return size / 2; }
+
+    GLsizei get_min_tile() const noexcept { return min_tile; }
+
+private:
+    GLsizei size;
+    GLsizei min_tile;
+    GLuint texture{0};
+    GLuint fbo{0};
+    std::vector<Tile> tiles;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Cached static layer of one shadow map (a 2D map or a cubemap). After the
+// static casters are rendered into the live map, store() copies it aside;
+// when only dynamic casters change, restore() puts the static layer back so
+// they can be drawn on top without re-rendering the static scene. A map
+// whose light does not move and whose volume sees no changes is not touched
+// at all.
+class ShadowCache
+{
+public:
+    // `target` is GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP; `live_texture` is
+    // the depth map the shaders sample, and the cached map is its square of
+    // side `size` at (`live_x`, `live_y`), e.g. one tile of a ShadowAtlas
+    ShadowCache(GLenum _target, GLuint _live_texture, GLsizei _size, GLint _live_x = 0, GLint _live_y = 0) noexcept;
+
+    ShadowCache(const ShadowCache& cache) = delete;
+
+    ShadowCache(ShadowCache&& cache) = delete;
+
+    ~ShadowCache();
+
+    ShadowCache& operator = (const ShadowCache& cache) = delete;
+
+    ShadowCache& operator = (ShadowCache&& cache) = delete;
+
+    // Copy the live map into the static layer and remember the light
+    // position it was rendered from
+    void store(const glm::vec3& light_position) noexcept;
+
+    // Copy the static layer back into the live map
+    void restore() const noexcept;
+
+    // True until store() ran for the current light position
+    bool is_stale(const glm::vec3& light_position) const noexcept { return !valid || light_position != stored_position; }
+
+    void invalidate() noexcept { valid = false; }
+
+private:
+    void copy(GLuint source, GLint source_x, GLint source_y, GLuint destination, GLint destination_x, GLint destination_y) const noexcept;
+
+    GLenum target;
+    GLuint live_texture;
+    GLsizei size;
+    GLint live_x;
+    GLint live_y;
+    GLuint static_texture{0};
+    GLuint read_fbo{0};
+    GLuint draw_fbo{0};
+    bool valid{false};
+    glm::vec3 stored_position{0.0f};
+};
@@ -15,6 +15,12 @@ public:
     float get_far_plane() const noexcept { return far_plane; }
     unsigned int get_size() const noexcept { return map_size; }
 
+    // Bind the FBO with a single face as its depth attachment (six-pass
+    // rendering), or with the whole cubemap as a layered attachment so a
+    // geometry shader can pick the face through gl_Layer
+    void attach_face(unsigned int face) const noexcept;
+    void attach_layered() const noexcept;
+
     // Returns projection*view matrices for the 6 cubemap faces for a point light at light_pos
     std::vector<glm::mat4> get_shadow_matrices(const glm::vec3& light_pos, float near_plane) const noexcept;
     // Returns only the view matrices (lookAt) for the 6 cubemap faces
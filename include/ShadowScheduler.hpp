@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Spreads shadow map refreshes over frames. Each light is registered with
+// its cost in rendered faces (6 for a cubemap, 1 for a spot map). Dirty
+// lights are requested every frame with an importance; schedule() then picks
+// the most important ones that fit in the per-frame face budget. Waiting
+// raises a request's priority, so no light starves.
+class ShadowScheduler
+{
+public:
+    struct LightStats
+    {
+        std::string name;
+        unsigned faces{1};
+        std::size_t refreshes{0};
+        // Frames between the first request and the refresh that served it
+        std::size_t last_wait{0};
+        std::size_t worst_wait{0};
+    };
+
+    explicit ShadowScheduler(unsigned _face_budget = 8) noexcept;
+
+    ShadowScheduler(const ShadowScheduler& scheduler) = delete;
+
+    ShadowScheduler(ShadowScheduler&& scheduler) = delete;
+
+    ShadowScheduler& operator = (const ShadowScheduler& scheduler) = delete;
+
+    ShadowScheduler& operator = (ShadowScheduler&& scheduler) = delete;
+
+    // Register a light and return its id
+    std::size_t add_light(std::string name, unsigned faces) noexcept;
+
+    // Ask for a refresh of `light` this frame. Importance is any positive
+    // score (e.g. screen coverage); repeated requests keep the largest. A
+    // `required` refresh is granted this frame whatever the budget, for maps
+    // that hold nothing valid (e.g. a spot whose atlas tile moved).
+    void request(std::size_t light, float importance, bool required = false) noexcept;
+
+    // Lights to refresh this frame, required ones first, then most urgent
+    // first. The first one is always granted even if it alone exceeds the
+    // budget. Lights returned
+    // here count as refreshed; the others stay pending.
+    const std::vector<std::size_t>& schedule() noexcept;
+
+    bool is_pending(std::size_t light) const noexcept { return pending[light].requested; }
+
+    void set_face_budget(unsigned budget) noexcept { face_budget = budget; }
+
+    unsigned get_face_budget() const noexcept { return face_budget; }
+
+    // Faces granted by the last schedule()
+    unsigned get_scheduled_faces() const noexcept { return scheduled_faces; }
+
+    const std::vector<LightStats>& get_stats() const noexcept { return stats; }
+
+private:
+    struct Request
+    {
+        bool requested{false};
+        bool required{false};
+        float importance{0.0f};
+        std::size_t first_frame{0};
+    };
+
+    unsigned face_budget;
+    unsigned scheduled_faces{0};
+    std::size_t frame{0};
+    std::vector<Request> pending;
+    std::vector<LightStats> stats;
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> granted;
+};
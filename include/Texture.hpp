@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 
 #include <GL/glew.h>
 
@@ -8,6 +9,15 @@
 
 #include <BSlogger.hpp>
 
+// CPU-side RGBA8 pixels as decoded by stb_image. Decoding touches no GL
+// state, so images can be produced on worker threads and uploaded later.
+struct TextureImage
+{
+    int width{0};
+    int height{0};
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{nullptr, stbi_image_free};
+};
+
 class Texture
 {
 public:
@@ -21,7 +31,14 @@ public:
 
     void load() noexcept;
 
-    void use() const noexcept;
+    // Upload pixels that were decoded ahead of time (see decode()).
+    void load(const TextureImage& image) noexcept;
+
+    // Decode an image file into RGBA8 pixels without touching GL.
+    static TextureImage decode(const std::filesystem::path& file_path) noexcept;
+
+    // Bind to texture unit `unit` (albedo maps use 0, normal maps 1)
+    void use(GLuint unit = 0) const noexcept;
 
     GLuint get_id() const noexcept { return id; }
 
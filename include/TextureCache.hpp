@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <Texture.hpp>
+
+// Process-wide registry of 2D textures. File textures are keyed by their
+// canonical path plus the format they are uploaded with; solid colours are
+// keyed by their RGBA value. Every caller asking for the same image gets the
+// same shared handle, so decode time and VRAM scale with unique images.
+class TextureCache
+{
+public:
+    TextureCache() = delete;
+
+    // Returns the texture for file_path, decoding and uploading it only the
+    // first time it is requested (or after every previous handle was released).
+    static std::shared_ptr<Texture> get(const std::filesystem::path& file_path) noexcept;
+
+    // Same as get(), but on a miss uploads pixels that were already decoded
+    // (e.g. on a loader worker thread) instead of reading the file again.
+    static std::shared_ptr<Texture> get(const std::filesystem::path& file_path, const TextureImage& decoded) noexcept;
+
+    // Returns a shared 1x1 solid color texture (r,g,b,a) in [0..255]
+    static std::shared_ptr<Texture> get_solid(unsigned char r, unsigned char g, unsigned char b, unsigned char a = 255) noexcept;
+
+    static std::size_t get_hits() noexcept { return hits; }
+
+    static std::size_t get_misses() noexcept { return misses; }
+
+    // Number of textures currently alive in the registry
+    static std::size_t get_live_count() noexcept;
+
+    static void log_stats() noexcept;
+
+private:
+    static std::string make_file_key(const std::filesystem::path& file_path) noexcept;
+
+    static std::string make_solid_key(unsigned char r, unsigned char g, unsigned char b, unsigned char a) noexcept;
+
+    // Entries are weak so the registry never extends a texture's lifetime
+    // past its last user.
+    static std::unordered_map<std::string, std::weak_ptr<Texture>> entries;
+    static std::size_t hits;
+    static std::size_t misses;
+};
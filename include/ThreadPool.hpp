@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from a single FIFO queue. Tasks must
+// not touch GL state: results are handed back through futures and uploaded
+// by the thread that owns the context.
+class ThreadPool
+{
+public:
+    // thread_count == 0 picks one worker per hardware thread.
+    explicit ThreadPool(std::size_t thread_count = 0) noexcept;
+
+    ThreadPool(const ThreadPool& pool) = delete;
+
+    ThreadPool(ThreadPool&& pool) = delete;
+
+    ~ThreadPool();
+
+    ThreadPool& operator = (const ThreadPool& pool) = delete;
+
+    ThreadPool& operator = (ThreadPool&& pool) = delete;
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& task)
+    {
+        using Result = std::invoke_result_t<F>;
+
+        // std::function needs a copyable callable, so the packaged_task lives
+        // behind a shared_ptr.
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            tasks.emplace([packaged]() { (*packaged)(); });
+        }
+        condition.notify_one();
+        return result;
+    }
+
+    std::size_t get_thread_count() const noexcept { return workers.size(); }
+
+private:
+    void worker_loop() noexcept;
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping{false};
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Matrix taking normals to world space under `model`. When the upper 3x3
+// only rotates (or mirrors) and scales uniformly, it is that 3x3 itself: the
+// shaders renormalize, so the scale drops out. Otherwise it is the inverse
+// transpose.
+glm::mat3 normal_matrix(const glm::mat4& model) noexcept;
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// CPU mirrors of the std140 uniform blocks declared in shaders/*.vert/frag.
+// Every member is a vec4 or mat4 (or padded up to one) so the C++ layout is
+// the std140 layout; keep the two sides in sync. Binding points are fixed per
+// block and assigned to each program by UniformBuffer::attach.
+
+// Per-frame camera data ("Frame" block)
+struct FrameBlock
+{
+    static constexpr const char* NAME = "Frame";
+    static constexpr GLuint BINDING = 0;
+
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec4 view_position{0.0f}; // xyz
+};
+
+struct DirLightData
+{
+    glm::vec4 direction{0.0f}; // xyz
+    glm::vec4 diffuse{0.0f};   // rgb
+    glm::vec4 specular{0.0f};  // rgb
+};
+
+struct PointLightData
+{
+    glm::vec4 position{0.0f};    // xyz
+    glm::vec4 ambient{0.0f};     // rgb
+    glm::vec4 diffuse{0.0f};     // rgb
+    glm::vec4 specular{0.0f};    // rgb
+    glm::vec4 attenuation{0.0f}; // constant, linear, quadratic
+};
+
+struct SpotLightData
+{
+    glm::vec4 position{0.0f};    // xyz
+    glm::vec4 direction{0.0f};   // xyz
+    glm::vec4 ambient{0.0f};     // rgb
+    glm::vec4 diffuse{0.0f};     // rgb
+    glm::vec4 specular{0.0f};    // rgb
+    glm::vec4 attenuation{0.0f}; // constant, linear, quadratic
+    glm::vec4 cone{0.0f};        // cos(inner angle), cos(outer angle)
+};
+
+// Lighting shared by every draw ("Lights" block). Point and spot lights are
+// not in the block: they live in the light buffer built by LightClusters,
+// and each fragment only walks the lights of its cluster.
+struct LightsBlock
+{
+    static constexpr const char* NAME = "Lights";
+    static constexpr GLuint BINDING = 1;
+
+    static constexpr int MAX_DIR_LIGHTS = 2;
+
+    // Directional light slots, selected per draw with the dirLightIndex uniform
+    static constexpr int DIR_LIGHT_INTERIOR = 0;
+    static constexpr int DIR_LIGHT_EXTERIOR = 1;
+
+    // Cluster grid: tiles across, tiles down, depth slices, light count
+    glm::ivec4 cluster_grid{0};
+    // Fragment to cluster: tiles per pixel (x, y), then the scale and bias
+    // taking log(view depth) to a slice
+    glm::vec4 cluster_mapping{0.0f};
+    DirLightData dir_lights[MAX_DIR_LIGHTS];
+};
+
+// Shadow map parameters ("Shadows" block)
+struct ShadowsBlock
+{
+    static constexpr const char* NAME = "Shadows";
+    static constexpr GLuint BINDING = 2;
+
+    // Spot lights with a shadow map; a light's slot is its shadow index
+    // (see LightClusters::add)
+    static constexpr int MAX_SPOT_SHADOWS = 5;
+
+    glm::mat4 spot_light_space[MAX_SPOT_SHADOWS];
+    // Each spot map's tile in the shadow atlas: uv offset xy, uv scale zw
+    glm::vec4 spot_shadow_tiles[MAX_SPOT_SHADOWS];
+    GLfloat far_plane{0.0f};
+    GLfloat shadow_radius{0.0f};
+    GLfloat padding[2]{};
+};
+
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock must match the std140 layout");
+static_assert(sizeof(DirLightData) == 48 && sizeof(PointLightData) == 80 && sizeof(SpotLightData) == 112,
+              "Light structs must match the std140 layout");
+static_assert(sizeof(LightsBlock) == 2 * 16 + 2 * 48, "LightsBlock must match the std140 layout");
+static_assert(sizeof(ShadowsBlock) == 5 * 64 + 5 * 16 + 16, "ShadowsBlock must match the std140 layout");
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <GL/glew.h>
+
+#include <Shader.hpp>
+
+// Uniform buffer holding one std140 block (see UniformBlocks.hpp), bound to
+// the block's fixed binding point. The CPU struct is written whole, once per
+// frame, and every program attached to the block reads it from there.
+class UniformBuffer
+{
+public:
+    UniformBuffer(const char* _block_name, GLuint _binding, std::size_t _size) noexcept;
+
+    UniformBuffer(const UniformBuffer& buffer) = delete;
+
+    UniformBuffer(UniformBuffer&& buffer) = delete;
+
+    ~UniformBuffer();
+
+    UniformBuffer& operator = (const UniformBuffer& buffer) = delete;
+
+    UniformBuffer& operator = (UniformBuffer&& buffer) = delete;
+
+    template <typename Block>
+    static std::shared_ptr<UniformBuffer> create() noexcept
+    {
+        return std::make_shared<UniformBuffer>(Block::NAME, Block::BINDING, sizeof(Block));
+    }
+
+    // Route the program's block of the same name to this buffer. Programs
+    // that don't declare the block are left untouched.
+    void attach(const Shader& shader) const noexcept;
+
+    // Replace the whole contents with `block`
+    template <typename Block>
+    void write(const Block& block) noexcept
+    {
+        upload(&block, sizeof(Block));
+    }
+
+    GLuint get_id() const noexcept { return buffer_id; }
+
+    GLuint get_binding() const noexcept { return binding; }
+
+private:
+    void upload(const void* data, std::size_t data_size) noexcept;
+
+    const char* block_name;
+    GLuint binding;
+    std::size_t size;
+    GLuint buffer_id{0};
+};
@@ -16,6 +16,9 @@ public:
     // Render the wall with a shader and model matrix
     void render(const std::shared_ptr<Shader> &shader, const glm::mat4 &model) const;
 
+    // Render only the positions, for depth passes (no material or textures)
+    void render_depth(const std::shared_ptr<Shader> &shader, const glm::mat4 &model) const;
+
     std::shared_ptr<Mesh> get_mesh() const { return mesh; }
 
 private:
@@ -5,10 +5,18 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <future>
+#include <thread>
 
 #include <Camera.hpp>
 #include <Mesh.hpp>
 #include <Shader.hpp>
+#include <ShaderCache.hpp>
 #include <Window.hpp>
 #include <Room.hpp>
 #include <PointLight.hpp>
@@ -17,7 +25,20 @@
 #include <AssimpLoader.hpp>
 #include <Frustum.hpp>
 #include <Texture.hpp>
+#include <TextureCache.hpp>
+#include <MeshCache.hpp>
 #include <ShadowCubemap.hpp>
+#include <PortalGraph.hpp>
+#include <ShadowAtlas.hpp>
+#include <ShadowCache.hpp>
+#include <ShadowScheduler.hpp>
+#include <Scene.hpp>
+#include <GLState.hpp>
+#include <GpuQuery.hpp>
+#include <GBuffer.hpp>
+#include <LightClusters.hpp>
+#include <UniformBlocks.hpp>
+#include <UniformBuffer.hpp>
 
 namespace fs = std::filesystem;
 
@@ -33,6 +54,7 @@ struct Data
     static std::shared_ptr<Mesh> exterior_floor_mesh;
     static std::shared_ptr<Texture> exterior_floor_texture;
     static std::shared_ptr<Texture> exterior_floor_normal_texture;
+    static bool exterior_floor_has_normal_map;
     static bool exterior_floor_initialized;
 };
 
@@ -41,6 +63,7 @@ std::shared_ptr<SkyBox> Data::sky_box{nullptr};
 std::shared_ptr<Mesh> Data::exterior_floor_mesh{nullptr};
 std::shared_ptr<Texture> Data::exterior_floor_texture{nullptr};
 std::shared_ptr<Texture> Data::exterior_floor_normal_texture{nullptr};
+bool Data::exterior_floor_has_normal_map = false;
 bool Data::exterior_floor_initialized = false;
 
 const fs::path Data::root_path{fs::path{__FILE__}.parent_path()};
@@ -49,9 +72,49 @@ const fs::path Data::lightbulb_vertex_shader_path{Data::root_path / "shaders" /
 const fs::path Data::fragment_shader_path{Data::root_path / "shaders" / "shader.frag"};
 const fs::path Data::lightbulb_fragment_shader_path{Data::root_path / "shaders" / "lightbulb.frag"};
 
+struct SceneConfig
+{
+    static constexpr GLint WIDTH = 1200;
+    static constexpr GLint HEIGHT = 800;
+    static constexpr float SPOT_OUTER_DEG = 40.0f;
+    static constexpr float ROOM_SPACING = 20.0f;
+    static constexpr unsigned int SHADOW_SIZE = 1024;
+    static constexpr float SHADOW_FAR = 20.0f;
+    static constexpr unsigned int SPOT_ATLAS_SIZE = 2048;
+    static constexpr unsigned int SPOT_TILE_MIN = 128;
+    static constexpr int SPOT_COUNT = 5;
+    static constexpr unsigned int CLUSTER_TILES_X = 16;
+    static constexpr unsigned int CLUSTER_TILES_Y = 9;
+    static constexpr unsigned int CLUSTER_SLICES = 24;
+    // Stress test for clustered lighting, off so the museum keeps its look
+    static constexpr bool ACCENT_LIGHTS = false;
+    static constexpr int ACCENT_LIGHTS_PER_WALL = 12;
+    static constexpr bool SHADOWS = true;
+    static constexpr int POINT_PCF_SAMPLES = 12;
+    static constexpr int SPOT_PCF_SAMPLES = 4;
+};
+
+// Defines of a surface program variant (shaders/surface.glsl and
+// lighting.glsl). Shadows and PCF kernels follow SceneConfig; `normal_map`
+// and `point_shadows` are what the draw needs, so draws that need less get a
+// cheaper program.
+ShaderDefines surface_defines(bool normal_map, bool point_shadows) noexcept
+{
+    return {
+        "NORMAL_MAP " + std::to_string(normal_map ? 1 : 0),
+        "POINT_SHADOWS " + std::to_string(point_shadows && SceneConfig::SHADOWS ? 1 : 0),
+        "SPOT_SHADOWS " + std::to_string(SceneConfig::SHADOWS ? 1 : 0),
+        "POINT_PCF_SAMPLES " + std::to_string(SceneConfig::POINT_PCF_SAMPLES),
+        "SPOT_PCF_SAMPLES " + std::to_string(SceneConfig::SPOT_PCF_SAMPLES),
+        "NR_DIR_LIGHTS " + std::to_string(LightsBlock::MAX_DIR_LIGHTS),
+        "NR_SPOT_SHADOWS " + std::to_string(ShadowsBlock::MAX_SPOT_SHADOWS),
+    };
+}
+
 void create_shaders_program() noexcept
 {
-    Data::shader_list.push_back(Shader::create_from_files(Data::vertex_shader_path, Data::fragment_shader_path));
+    // The full-featured forward variant
+    Data::shader_list.push_back(ShaderCache::get(Data::vertex_shader_path, Data::fragment_shader_path, surface_defines(true, true)));
     Data::shader_list.push_back(Shader::create_from_files(Data::lightbulb_vertex_shader_path, Data::lightbulb_fragment_shader_path));
 }
 
@@ -62,121 +125,189 @@ void UIResponsiveWhileLoading(std::shared_ptr<Window> window) noexcept
     window->swap_buffers();
 }
 
-void placeModelInPosition(std::vector<AssimpLoader::Renderable> model, glm::vec3 vec3, bool cullingEnabled, Frustum frustum, float radius, float scale, std::shared_ptr<Texture> fallback_albedo, std::shared_ptr<Texture> fallback_normal) noexcept
+// Load all model files in parallel. Returns one Renderable group per file, in
+// the same order as `files`.
+std::vector<std::vector<AssimpLoader::Renderable>> load_models_async(std::shared_ptr<Window> window, const std::vector<fs::path>& files) noexcept
 {
-    glm::vec3 statuePos = vec3;
-    if (!cullingEnabled || frustum.isSphereInFrustum(statuePos, radius))
+    GLfloat start_time = glfwGetTime();
+
+    std::vector<std::future<AssimpLoader::ModelData>> pending;
+    for (const auto& file : files)
     {
-        glm::mat4 modelMat{1.0f};
-        modelMat = glm::translate(modelMat, statuePos);
-        modelMat = glm::scale(modelMat, glm::vec3(scale));
-        for (auto &r : model)
-        {
-            glm::mat4 m = modelMat * r.transform;
-            glUniformMatrix4fv(Data::shader_list[0]->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(m));
-            if (r.albedo)
-                r.albedo->use();
-            else
-                fallback_albedo->use();
-            glActiveTexture(GL_TEXTURE1);
-            if (r.normal)
-                glBindTexture(GL_TEXTURE_2D, r.normal->get_id());
-            else
-                glBindTexture(GL_TEXTURE_2D, fallback_normal->get_id());
-            r.mesh->render();
-        }
+        pending.push_back(AssimpLoader::loadModelAsync(file));
     }
-}
 
-void placeModelInPosition(std::vector<AssimpLoader::Renderable> models, std::vector<glm::vec3> positions, std::vector<float> rot, bool cullingEnabled, Frustum frustum, float radius, float scale, std::shared_ptr<Texture> fallback_albedo, std::shared_ptr<Texture> fallback_normal) noexcept
-{
-    for (auto &pr : models)
+    std::vector<std::vector<AssimpLoader::Renderable>> models(files.size());
+    std::vector<bool> uploaded(files.size(), false);
+    size_t remaining = files.size();
+
+    while (remaining > 0)
     {
-        for (size_t i = 0; i < positions.size(); ++i)
+        for (size_t i = 0; i < pending.size(); ++i)
         {
-            if (!cullingEnabled || frustum.isSphereInFrustum(positions[i], radius))
-            {
-                glm::mat4 modelMat{1.0f};
-                modelMat = glm::translate(modelMat, positions[i]);
-                modelMat = glm::rotate(modelMat, rot[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                modelMat = glm::scale(modelMat, glm::vec3(scale));
-                modelMat = modelMat * pr.transform;
+            if (uploaded[i] || pending[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                continue;
 
-                glUniformMatrix4fv(Data::shader_list[0]->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
+            std::cout << "Loading: " << files[i].filename().string() << std::endl;
+            models[i] = AssimpLoader::uploadModel(pending[i].get());
+            uploaded[i] = true;
+            --remaining;
+        }
 
-                if (pr.albedo)
-                    pr.albedo->use();
-                else
-                    fallback_albedo->use();
+        UIResponsiveWhileLoading(window);
+        if (remaining > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 
-                glActiveTexture(GL_TEXTURE1);
-                if (pr.normal)
-                    glBindTexture(GL_TEXTURE_2D, pr.normal->get_id());
-                else
-                    glBindTexture(GL_TEXTURE_2D, fallback_normal->get_id());
+    std::cout << "Loaded " << files.size() << " models in " << (glfwGetTime() - start_time) << " s" << std::endl;
+    return models;
+}
 
-                pr.mesh->render();
-            }
-        }
-    }
+// Translate, rotate about +Y, then scale uniformly: how every group is placed
+glm::mat4 make_placement(const glm::vec3 &position, float rotation, float scale) noexcept
+{
+    glm::mat4 modelMat = glm::translate(glm::mat4{1.0f}, position);
+    modelMat = glm::rotate(modelMat, rotation, glm::vec3(0.0f, 1.0f, 0.0f));
+    return glm::scale(modelMat, glm::vec3(scale));
 }
 
-void renderModelSpotShadow(std::vector<AssimpLoader::Renderable> model, glm::vec3 vec3, glm::vec3 spos, float far_plane_spot, bool cullingEnabled, Frustum frustum, float radius, float scale, std::shared_ptr<Shader> spotDepthShader) noexcept
+// Register the museum layout. `models` holds one Renderable group per file in
+// the order load_models_async was given: table, 4 props, potted plant,
+// 2 picture frames, 5 statues, small potted plant, mango tree.
+void populate_scene(Scene &scene, const std::vector<std::vector<AssimpLoader::Renderable>> &models) noexcept
 {
-    glm::vec3 statuePos = vec3;
-    if (glm::length(statuePos - spos) > far_plane_spot + 5.0f)
-    {
-        // too far
-    }
-    else if (!cullingEnabled || frustum.isSphereInFrustum(statuePos, radius))
+    const float floorY = -2.0f;
+
+    auto place = [&](Scene::ModelId model, const glm::vec3 &position, float rotation, float scale) {
+        scene.add_instance(model, make_placement(position, rotation, scale));
+    };
+
+    // Tables against the outer walls, one prop on each
+    const auto &tables = models[0];
+    const float modelScale = 2.0f;
+    const glm::vec3 positions[] = {
+        glm::vec3(0.0f, floorY, 28.5f), glm::vec3(0.0f, floorY, -28.5f),
+        glm::vec3(28.5f, floorY, 0.0f), glm::vec3(-28.5f, floorY, 0.0f)};
+    const float rotations[] = {0.0f, glm::pi<float>(), glm::radians(-90.0f), glm::radians(90.0f)};
+
+    if (!tables.empty())
     {
-        glm::mat4 modelMat{1.0f};
-        modelMat = glm::translate(modelMat, statuePos);
-        modelMat = glm::scale(modelMat, glm::vec3(scale));
-        for (auto &r : model)
+        Scene::ModelId table = scene.add_model(tables);
+        for (int i = 0; i < 4; ++i)
+            place(table, positions[i], rotations[i], modelScale);
+
+        float tableHeight = 0.0f;
+        for (auto &r : tables)
         {
-            glm::mat4 m = modelMat * r.transform;
-            glUniformMatrix4fv(spotDepthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(m));
-            r.mesh->render();
+            tableHeight = std::max(tableHeight, r.src_max.y - r.src_min.y);
         }
-    }
-}
+        tableHeight *= modelScale;
 
-void renderModelPointShadow(std::vector<AssimpLoader::Renderable> model, glm::vec3 vec3, bool cullingEnabled, Frustum frustum, float radius, float scale, std::shared_ptr<Shader> shader) noexcept
-{
-    glm::vec3 statuePos = vec3;
-    if (!cullingEnabled || frustum.isSphereInFrustum(statuePos, radius))
-    {
-        glm::mat4 modelMat{1.0f};
-        modelMat = glm::translate(modelMat, statuePos);
-        modelMat = glm::scale(modelMat, glm::vec3(scale));
-        for (auto &r : model)
+        // Each prop part is scaled to a footprint and centered on its own
+        // bounds, which becomes the part's local transform.
+        const float perPropFootprint[] = {0.15f, 0.6f, 0.8f, 1.5f};
+        for (int i = 0; i < 4; ++i)
+        {
+            std::vector<Scene::Part> parts;
+            for (auto &pr : models[1 + i])
+            {
+                glm::vec3 srcSize = pr.src_max - pr.src_min;
+                glm::vec3 srcCenter = (pr.src_min + pr.src_max) * 0.5f;
+                float footprintDim = std::max(0.001f, std::max(srcSize.x, srcSize.z));
+                float scaleUniform = std::clamp(perPropFootprint[i] / footprintDim, 0.02f, 10.0f);
+
+                glm::vec3 centerXZ = glm::vec3(srcCenter.x, 0.0f, srcCenter.z);
+                parts.push_back(Scene::Part{pr, glm::scale(glm::mat4{1.0f}, glm::vec3(scaleUniform)) * pr.transform * glm::translate(glm::mat4(1.0f), -centerXZ)});
+            }
+
+            glm::vec3 basePos = positions[i];
+            basePos.y = floorY + tableHeight + 0.02f;
+            place(scene.add_model(std::move(parts)), basePos, 0.0f, 1.0f);
+        }
+
+        // Potted plants in the central room's corners
+        const glm::vec3 potPositions[] = {
+            glm::vec3(8.0f, floorY, 8.0f), glm::vec3(-8.0f, floorY, 8.0f),
+            glm::vec3(8.0f, floorY, -8.0f), glm::vec3(-8.0f, floorY, -8.0f)};
+        const float potRot[] = {0.0f, glm::pi<float>(), glm::radians(90.0f), glm::radians(-90.0f)};
+        Scene::ModelId pot = scene.add_model(models[5]);
+        for (int i = 0; i < 4; ++i)
+            place(pot, potPositions[i], potRot[i], 4.0f);
+
+        // Two frames on each wall of the central room
+        const float pictureYOffset = 3.5f;
+        const float pictureShift = 4.0f;
+        const float wallDist = 9.8f;
+        const float picScale = 4.0f;
+        const glm::vec3 picPositions[] = {
+            glm::vec3(pictureShift, floorY + pictureYOffset, wallDist),
+            glm::vec3(pictureShift, floorY + pictureYOffset, -wallDist),
+            glm::vec3(wallDist, floorY + pictureYOffset, pictureShift),
+            glm::vec3(-wallDist, floorY + pictureYOffset, pictureShift)};
+        const glm::vec3 pic2Positions[] = {
+            glm::vec3(-pictureShift, floorY + pictureYOffset, wallDist),
+            glm::vec3(-pictureShift, floorY + pictureYOffset, -wallDist),
+            glm::vec3(wallDist, floorY + pictureYOffset, -pictureShift),
+            glm::vec3(-wallDist, floorY + pictureYOffset, -pictureShift)};
+        const float picRot[] = {glm::pi<float>(), 0.0f, glm::radians(270.0f), glm::radians(90.0f)};
+        Scene::ModelId picture = scene.add_model(models[6]);
+        Scene::ModelId picture2 = scene.add_model(models[7]);
+        for (int i = 0; i < 4; ++i)
         {
-            glm::mat4 m = modelMat * r.transform;
-            glUniformMatrix4fv(shader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(m));
-            r.mesh->render();
+            place(picture, picPositions[i], picRot[i], picScale);
+            place(picture2, pic2Positions[i], picRot[i], picScale);
         }
     }
-}
 
-void renderModelSpotShadow(std::vector<AssimpLoader::Renderable> models, std::vector<glm::vec3> positions, std::vector<float> rot, bool cullingEnabled, Frustum frustum, float radius, float scale, std::shared_ptr<Shader> shader) noexcept
-{
-    for (auto &pr : models)
+    // One statue per room
+    const float defaultStatueScale = 12.0f;
+    const float cannonScale = 3.0f;
+    const float coffeeScale = 2.0f;
+    place(scene.add_model(models[8]), glm::vec3(0.0f, floorY, 0.0f), 0.0f, defaultStatueScale);
+    place(scene.add_model(models[9]), glm::vec3(20.0f, floorY, 0.0f), 0.0f, cannonScale);
+    place(scene.add_model(models[10]), glm::vec3(-20.0f, floorY, 0.0f), 0.0f, coffeeScale);
+    place(scene.add_model(models[11]), glm::vec3(0.0f, floorY, 20.0f), 0.0f, defaultStatueScale);
+    place(scene.add_model(models[12]), glm::vec3(0.0f, floorY, -20.0f), 0.0f, defaultStatueScale);
+
+    // Four small plants in the corners of each outer room
+    const glm::vec3 outerRoomCenters[] = {
+        glm::vec3(20.0f, 0.0f, 0.0f), glm::vec3(-20.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, -20.0f)};
+    const glm::vec3 cornerOffsets[] = {
+        glm::vec3(8.0f, 0.0f, 8.0f), glm::vec3(-8.0f, 0.0f, 8.0f),
+        glm::vec3(8.0f, 0.0f, -8.0f), glm::vec3(-8.0f, 0.0f, -8.0f)};
+    Scene::ModelId plant = scene.add_model(models[13]);
+    for (const auto &center : outerRoomCenters)
     {
-        for (size_t i = 0; i < positions.size(); ++i)
+        for (const auto &offset : cornerOffsets)
         {
-            if (!cullingEnabled || frustum.isSphereInFrustum(positions[i], radius))
-            {
-                glm::mat4 modelMat{1.0f};
-                modelMat = glm::translate(modelMat, positions[i]);
-                modelMat = glm::rotate(modelMat, rot[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                modelMat = glm::scale(modelMat, glm::vec3(scale));
-                modelMat = modelMat * pr.transform;
-                glUniformMatrix4fv(shader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                pr.mesh->render();
-            }
+            glm::vec3 pos = center + offset;
+            pos.y = floorY;
+            place(plant, pos, 0.0f, 4.0f);
         }
     }
+
+    // Mango trees outside
+    const glm::vec3 treePositions[] = {
+        glm::vec3(60.0f, -2.0f, 10.0f),
+        glm::vec3(-45.0f, -2.0f, 15.0f),
+        glm::vec3(35.0f, -2.0f, -35.0f),
+
+        glm::vec3(40.0f, -2.0f, 35.0f),
+        glm::vec3(-35.0f, -2.0f, 40.0f),
+
+        glm::vec3(30.0f, -2.0f, -45.0f),
+        glm::vec3(-40.0f, -2.0f, -35.0f),
+
+        glm::vec3(55.0f, -2.0f, -20.0f),
+        glm::vec3(-50.0f, -2.0f, 20.0f),
+    };
+    const float treeScale = 2.0f;
+    Scene::ModelId tree = scene.add_model(models[14]);
+    for (const auto &position : treePositions)
+        place(tree, position, 0.0f, treeScale);
+
+    scene.build();
 }
 
 void initialize_exterior_floor()
@@ -197,97 +328,111 @@ void initialize_exterior_floor()
 
     Data::exterior_floor_mesh = Mesh::create(floor_vertices, floor_indices);
 
-    Data::exterior_floor_texture = std::make_shared<Texture>(Data::root_path / "textures" / "grass_albedo.jpg");
-    Data::exterior_floor_texture->load();
+    Data::exterior_floor_texture = TextureCache::get(Data::root_path / "textures" / "grass_albedo.jpg");
     if (!Data::exterior_floor_texture->get_id())
     {
-        Data::exterior_floor_texture = std::make_shared<Texture>(150, 150, 150, 255);
-        Data::exterior_floor_texture->load();
+        Data::exterior_floor_texture = TextureCache::get_solid(150, 150, 150, 255);
     }
 
-    Data::exterior_floor_normal_texture = std::make_shared<Texture>(Data::root_path / "textures" / "grass_normal.png");
-    Data::exterior_floor_normal_texture->load();
-    if (!Data::exterior_floor_normal_texture->get_id())
+    Data::exterior_floor_normal_texture = TextureCache::get(Data::root_path / "textures" / "grass_normal.png");
+    Data::exterior_floor_has_normal_map = Data::exterior_floor_normal_texture->get_id() != 0;
+    if (!Data::exterior_floor_has_normal_map)
     {
-        Data::exterior_floor_normal_texture = std::make_shared<Texture>(128, 128, 255, 255);
-        Data::exterior_floor_normal_texture->load();
+        Data::exterior_floor_normal_texture = TextureCache::get_solid(128, 128, 255, 255);
     }
 
     Data::exterior_floor_initialized = true;
 }
 
-void render_exterior_floor(const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &position)
+// Drawn with `shader`: the forward or G-buffer variant for the floor, which
+// is built without the point shadow (see surface_defines)
+void render_exterior_floor(const std::shared_ptr<Shader> &shader)
 {
     if (!Data::exterior_floor_initialized)
         return;
 
-    Data::shader_list[0]->use();
-
-    // Configurar matrices
-    glUniformMatrix4fv(Data::shader_list[0]->get_uniform_view_id(), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(Data::shader_list[0]->get_uniform_projection_id(), 1, GL_FALSE, glm::value_ptr(projection));
+    shader->use();
 
     // Matriz de modelo
     glm::mat4 model{1.0f};
-    glUniformMatrix4fv(Data::shader_list[0]->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(model));
+    shader->set_model(model);
 
     // Configurar texturas
-    glUniform1i(Data::shader_list[0]->get_uniform_texture_sampler_id(), 0);
-    glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "normal_sampler"), 1);
-
-    // DESACTIVAR SOMBRAS para el piso exterior
-    glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "enableShadows"), 0);
+    glUniform1i(shader->get_uniform_texture_sampler_id(), 0);
+    glUniform1i(shader->get_uniform_location("normal_sampler"_uniform), 1);
 
-    // LUZ DIRECCIONAL FUERTE (como sol exterior)
-    glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "dirLight.direction"), -1.0f, -0.5f, -0.5f);
-    glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "dirLight.diffuse"), 1.5f, 1.5f, 1.3f);
-    glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "dirLight.specular"), 0.2f, 0.2f, 0.2f);
+    // LUZ DIRECCIONAL FUERTE (como sol exterior), ya cargada en el bloque Lights
+    glUniform1i(shader->get_uniform_location("dirLightIndex"_uniform), LightsBlock::DIR_LIGHT_EXTERIOR);
 
     // Usar textura del piso (Unit 0)
-    Data::exterior_floor_texture->use();
-    glUniform1i(Data::shader_list[0]->get_uniform_texture_sampler_id(), 0);
+    Data::exterior_floor_texture->use(0);
+    glUniform1i(shader->get_uniform_texture_sampler_id(), 0);
 
-    // Usar normal map (Unit 1)
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, Data::exterior_floor_normal_texture->get_id());
-    glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "normal_sampler"), 1);
+    // Usar normal map (Unit 1), si la variante lo lee
+    if (Data::exterior_floor_has_normal_map)
+    {
+        Data::exterior_floor_normal_texture->use(1);
+        glUniform1i(shader->get_uniform_location("normal_sampler"_uniform), 1);
+    }
 
     // Configurar material para césped
-    glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "material.shininess"), 16.0f);
-
-    // Posición de cámara
-    glUniform3fv(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "viewPosition"),
-                 1, glm::value_ptr(position));
+    glUniform1f(shader->get_uniform_location("material.shininess"_uniform), 16.0f);
 
     // Renderizar
     Data::exterior_floor_mesh->render();
 }
 
-struct SceneConfig
+// Positions of the exterior floor, for the depth prepass
+void render_exterior_floor_depth(const std::shared_ptr<Shader> &shader) noexcept
 {
-    static constexpr GLint WIDTH = 1200;
-    static constexpr GLint HEIGHT = 800;
-    static constexpr float SPOT_OUTER_DEG = 40.0f;
-    static constexpr float ROOM_SPACING = 20.0f;
-    static constexpr unsigned int SHADOW_SIZE = 1024;
-    static constexpr float SHADOW_FAR = 20.0f;
-    static constexpr unsigned int SPOT_SHADOW_RES = 1024;
-    static constexpr int SPOT_COUNT = 5;
-    static constexpr int SHADOW_UPDATE_INTERVAL = 6;
-};
+    if (!Data::exterior_floor_initialized)
+        return;
 
-int main()
+    glm::mat4 model{1.0f};
+    shader->set_model(model);
+    Data::exterior_floor_mesh->render_depth();
+}
+
+int main(int argc, char **argv)
 {
     constexpr GLint WIDTH = 1200;
     constexpr GLint HEIGHT = 800;
     const float spotOuterDeg = 40.0f;
 
-    auto main_window = Window::create(WIDTH, HEIGHT, "The Room");
+    // --benchmark [WIDTHxHEIGHT]: render a fixed set of views with each
+    // camera path, print their average GPU time and exit
+    bool benchmark = false;
+    GLint width = WIDTH;
+    GLint height = HEIGHT;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string{argv[i]} != "--benchmark")
+            continue;
+        benchmark = true;
+        if (i + 1 < argc && std::sscanf(argv[i + 1], "%dx%d", &width, &height) == 2)
+            ++i;
+    }
+
+    auto main_window = Window::create(width, height, "The Room");
     if (main_window == nullptr)
         return EXIT_FAILURE;
 
+    // Linked programs are kept across runs (see Shader::set_binary_cache_directory)
+    Shader::set_binary_cache_directory(Data::root_path / ".cache" / "shaders");
     create_shaders_program();
 
+    // Camera, light and shadow data live in std140 uniform buffers that are
+    // written once per frame and shared by every program declaring them
+    auto frameUniforms = UniformBuffer::create<FrameBlock>();
+    auto lightsUniforms = UniformBuffer::create<LightsBlock>();
+    auto shadowsUniforms = UniformBuffer::create<ShadowsBlock>();
+    for (const auto &shader : Data::shader_list)
+    {
+        frameUniforms->attach(*shader);
+        lightsUniforms->attach(*shader);
+        shadowsUniforms->attach(*shader);
+    }
+
     Frustum frustum;
     bool cullingEnabled = true;
 
@@ -311,68 +456,52 @@ int main()
     roomTransforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, roomSpacing)));
     roomTransforms.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -roomSpacing)));
 
-    // Create the shared mesh for all lightbulbs
-    Lightbulb::create_mesh();
-
-    // Create fallback textures
-    auto fallback_albedo = std::make_shared<Texture>(255, 255, 255, 255);
-    fallback_albedo->load();
-    auto fallback_normal = std::make_shared<Texture>(128, 128, 255, 255);
-    fallback_normal->load();
-
-    std::cout << "Loading: wooden_table_02_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> imported_models = AssimpLoader::loadModel(Data::root_path / "models" / "wooden_table_02_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::vector<std::vector<AssimpLoader::Renderable>> prop_models;
-    std::vector<std::string> prop_files = {
-        "lubricant_spray_1k.gltf", "marble_bust_01_1k.gltf", "rubber_duck_toy_1k.gltf", "street_rat_1k.gltf"};
-    for (auto &pf : prop_files)
-    {
-        auto group = AssimpLoader::loadModel(Data::root_path / "models" / pf);
-        prop_models.push_back(std::move(group));
-        UIResponsiveWhileLoading(main_window);
-    }
-
-    std::cout << "Loading: potted_plant_01_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> potted_models = AssimpLoader::loadModel(Data::root_path / "models" / "potted_plant_01_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::cout << "Loading: fancy_picture_frame_01_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> picture_models = AssimpLoader::loadModel(Data::root_path / "models" / "fancy_picture_frame_01_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
+    // Rooms are culled by their exact bounds, like scene instances
+    std::vector<Bounds> roomBounds;
+    for (const glm::mat4 &transform : roomTransforms)
+        roomBounds.push_back(Room::bounds(transform));
 
-    std::cout << "Loading: fancy_picture_frame_02_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> picture2_models = AssimpLoader::loadModel(Data::root_path / "models" / "fancy_picture_frame_02_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
+    // Rooms only see each other through their doorways: the camera pass
+    // culls against the part of the view that reaches each room
+    PortalGraph portals;
+    for (size_t i = 0; i < roomTransforms.size() && i < rooms.size(); ++i)
+        portals.add_room(roomTransforms[i], rooms[i].get_door_mask());
+    portals.build();
+    bool portalCulling = true;
+    bool portalKeyWasDown = false;
 
-    std::cout << "Loading: concrete_cat_statue_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> cat_statue = AssimpLoader::loadModel(Data::root_path / "models" / "concrete_cat_statue_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::cout << "Loading: cannon_01_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> cannon_statue = AssimpLoader::loadModel(Data::root_path / "models" / "cannon_01_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::cout << "Loading: CoffeeCart_01_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> cart_statue = AssimpLoader::loadModel(Data::root_path / "models" / "CoffeeCart_01_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::cout << "Loading: Drill_01_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> drill_statue = AssimpLoader::loadModel(Data::root_path / "models" / "Drill_01_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::cout << "Loading: horse_head_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> horse_statue = AssimpLoader::loadModel(Data::root_path / "models" / "horse_head_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
-
-    std::cout << "Loading: potted_plant_02_1k.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> potted_plant_02 = AssimpLoader::loadModel(Data::root_path / "models" / "potted_plant_02_1k.gltf");
-    UIResponsiveWhileLoading(main_window);
+    // Create the shared mesh for all lightbulbs
+    Lightbulb::create_mesh();
 
-    std::cout << "Loading: tree.gltf" << std::endl;
-    std::vector<AssimpLoader::Renderable> tree_models = AssimpLoader::loadModel(Data::root_path / "models" / "mango_tree" / "scene.gltf");
-    UIResponsiveWhileLoading(main_window);
+    // Cooked meshes let warm starts skip Assimp entirely
+    MeshCache::set_directory(Data::root_path / ".cache" / "meshes");
+
+    // Kick off every import on the loader pool, then upload each model on
+    // this (GL) thread as soon as its CPU-side data is ready while the
+    // window keeps presenting frames.
+    std::vector<fs::path> model_files = {
+        Data::root_path / "models" / "wooden_table_02_1k.gltf",
+        Data::root_path / "models" / "lubricant_spray_1k.gltf",
+        Data::root_path / "models" / "marble_bust_01_1k.gltf",
+        Data::root_path / "models" / "rubber_duck_toy_1k.gltf",
+        Data::root_path / "models" / "street_rat_1k.gltf",
+        Data::root_path / "models" / "potted_plant_01_1k.gltf",
+        Data::root_path / "models" / "fancy_picture_frame_01_1k.gltf",
+        Data::root_path / "models" / "fancy_picture_frame_02_1k.gltf",
+        Data::root_path / "models" / "concrete_cat_statue_1k.gltf",
+        Data::root_path / "models" / "cannon_01_1k.gltf",
+        Data::root_path / "models" / "CoffeeCart_01_1k.gltf",
+        Data::root_path / "models" / "Drill_01_1k.gltf",
+        Data::root_path / "models" / "horse_head_1k.gltf",
+        Data::root_path / "models" / "potted_plant_02_1k.gltf",
+        Data::root_path / "models" / "mango_tree" / "scene.gltf"};
+    std::vector<std::vector<AssimpLoader::Renderable>> loaded_models = load_models_async(main_window, model_files);
+
+    // Every placement is computed here once; passes only cull and draw
+    Scene scene;
+    populate_scene(scene, loaded_models);
+
+    TextureCache::log_stats();
 
     std::vector<Lightbulb> lightbulbs;
     PointLight ceilingLight(glm::vec3{0.0f, 7.5f, 0.0f},
@@ -385,47 +514,56 @@ int main()
 
     for (int i = 0; i < 8; ++i)
     {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        GLState::bind_texture(i, GL_TEXTURE_2D, 0);
+        GLState::bind_texture(i, GL_TEXTURE_CUBE_MAP, 0);
     }
 
     auto depthShader = Shader::create_from_files(Data::root_path / "shaders" / "depth_cube.vert", Data::root_path / "shaders" / "depth_cube.frag");
     ShadowCubemap shadowCubemap(SHADOW_SIZE, SHADOW_FAR);
-
-    const int SPOT_COUNT = 5;
-    const unsigned int SPOT_SHADOW_RES = 1024;
-    std::vector<GLuint> spotDepthMaps(SPOT_COUNT, 0);
-    std::vector<GLuint> spotDepthFBOs(SPOT_COUNT, 0);
-
-    for (int i = 0; i < SPOT_COUNT; ++i)
-    {
-        glGenTextures(1, &spotDepthMaps[i]);
-        glBindTexture(GL_TEXTURE_2D, spotDepthMaps[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SPOT_SHADOW_RES, SPOT_SHADOW_RES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        float borderColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-        GLuint fbo = 0;
-        glGenFramebuffers(1, &fbo);
-        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, spotDepthMaps[i], 0);
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        {
-            std::cerr << "Spot shadow FBO not complete!" << std::endl;
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        spotDepthFBOs[i] = fbo;
-    }
+    // Single-pass alternative: a geometry shader routes triangles to the faces
+    auto layeredDepthShader = Shader::create_from_files(Data::root_path / "shaders" / "depth_cube_layered.vert",
+                                                        Data::root_path / "shaders" / "depth_cube.geom",
+                                                        Data::root_path / "shaders" / "depth_cube.frag");
+
+    // Every spot map is a tile of one atlas: a single texture, FBO and
+    // sampler. Tiles are sized per light (see spotTileSize below), from 1024
+    // for lights filling the view down to 128 for far ones.
+    const int SPOT_COUNT = SceneConfig::SPOT_COUNT;
+    ShadowAtlas spotAtlas(SceneConfig::SPOT_ATLAS_SIZE, SceneConfig::SPOT_TILE_MIN);
+    spotAtlas.pack(std::vector<GLsizei>(SPOT_COUNT, spotAtlas.get_max_tile()));
 
     auto spotDepthShader = Shader::create_from_files(Data::root_path / "shaders" / "spot_depth.vert", Data::root_path / "shaders" / "spot_depth.frag");
-    const bool enableShadows = true;
+    const bool enableShadows = SceneConfig::SHADOWS;
+
+    // Optional depth prepass (F4): the camera view is first drawn with
+    // positions only, then shaded with GL_EQUAL so every pixel runs the
+    // lighting shader once. Occlusion queries count the fragments that pass
+    // the depth test in each pass; in the prepass that is what shading alone
+    // would have cost.
+    auto prepassShader = Shader::create_from_files(Data::root_path / "shaders" / "depth_prepass.vert", Data::root_path / "shaders" / "depth_prepass.frag");
+    frameUniforms->attach(*prepassShader);
+    bool depthPrepass = true;
+    bool prepassKeyWasDown = false;
+    GpuQuery prepassSamples(GL_SAMPLES_PASSED);
+    GpuQuery shadedSamples(GL_SAMPLES_PASSED);
+
+    // Deferred shading (F6): surfaces are written to a G-buffer, then lit
+    // once per pixel by a full-screen pass with the same lights, clusters
+    // and shadows as the forward shader. The camera passes of each path are
+    // timed on the GPU.
+    auto deferredShader = ShaderCache::get(Data::root_path / "shaders" / "deferred_lighting.vert", Data::root_path / "shaders" / "deferred_lighting.frag",
+                                           surface_defines(true, true));
+    frameUniforms->attach(*deferredShader);
+    lightsUniforms->attach(*deferredShader);
+    shadowsUniforms->attach(*deferredShader);
+    GBuffer gbuffer(main_window->get_buffer_width(), main_window->get_buffer_height());
+    // The full-screen triangle has no vertex data, but a VAO must be bound
+    GLuint fullScreenVao = 0;
+    glGenVertexArrays(1, &fullScreenVao);
+    bool deferredShading = false;
+    bool deferredKeyWasDown = false;
+    GpuQuery forwardTime(GL_TIME_ELAPSED);
+    GpuQuery deferredTime(GL_TIME_ELAPSED);
 
     Data::sky_box = std::make_shared<SkyBox>(
         Data::root_path,
@@ -433,28 +571,345 @@ int main()
 
     glm::mat4 projection = glm::perspective(45.f, main_window->get_aspect_ratio(), 0.1f, 100.f);
     GLfloat last_time = glfwGetTime();
-    static int shadowUpdateCounter = 0;
-    const int SHADOW_UPDATE_INTERVAL = 6;
 
     initialize_exterior_floor();
 
-    std::vector<glm::vec3> tree_positions = {
-        glm::vec3(60.0f, -2.0f, 10.0f),
-        glm::vec3(-45.0f, -2.0f, 15.0f),
-        glm::vec3(35.0f, -2.0f, -35.0f),
+    // Culled instance lists, reused every frame
+    Scene::VisibleSet camera_visible;
+    Scene::VisibleSet lightCasters;
+    Scene::VisibleSet casters;
+    Scene::VisibleSet dynamicCasters;
+    // Boxes of a point shadow's casters, culled per cubemap face
+    AABBArrays casterBounds;
+    std::vector<std::uint32_t> faceCasters;
+    // Instances drawn over all shadow views this frame
+    std::size_t shadowCastersDrawn = 0;
+
+    // Directional lights never change and are filled once. Point and spot
+    // lights are handed to the light clusters every frame, since the point
+    // light can be moved.
+    LightsBlock lights;
+    lights.dir_lights[LightsBlock::DIR_LIGHT_INTERIOR] = {glm::vec4{-0.2f, -1.0f, -0.3f, 0.0f}, glm::vec4{0.5f, 0.5f, 0.5f, 0.0f}, glm::vec4{0.1f, 0.1f, 0.1f, 0.0f}};
+    lights.dir_lights[LightsBlock::DIR_LIGHT_EXTERIOR] = {glm::vec4{-1.0f, -0.5f, -0.5f, 0.0f}, glm::vec4{1.5f, 1.5f, 1.3f, 0.0f}, glm::vec4{0.2f, 0.2f, 0.2f, 0.0f}};
+    std::vector<SpotLightData> spotLights(std::min<size_t>(roomTransforms.size(), SPOT_COUNT));
+    for (size_t si = 0; si < spotLights.size(); ++si)
+    {
+        SpotLightData &spot = spotLights[si];
+        spot.position = roomTransforms[si] * glm::vec4(0.0f, 7.5f, 0.0f, 1.0f);
+        spot.direction = glm::vec4{0.0f, -1.0f, 0.0f, 0.0f};
+        spot.ambient = glm::vec4{0.02f, 0.02f, 0.02f, 0.0f};
+        spot.diffuse = glm::vec4{3.0f, 3.0f, 2.7f, 0.0f};
+        spot.specular = glm::vec4{1.0f, 1.0f, 1.0f, 0.0f};
+        spot.attenuation = glm::vec4{1.0f, 0.09f, 0.032f, 0.0f};
+        spot.cone = glm::vec4{std::cos(glm::radians(30.0f)), std::cos(glm::radians(spotOuterDeg)), 0.0f, 0.0f};
+    }
 
-        glm::vec3(40.0f, -2.0f, 35.0f),
-        glm::vec3(-35.0f, -2.0f, 40.0f),
+    // Small uplights along the foot of every wall, reaching a few meters
+    // each, to load the light clusters (F7, SceneConfig::ACCENT_LIGHTS).
+    // Shading them all per pixel would be unaffordable; clustered, a
+    // fragment only sees the handful around it.
+    std::vector<PointLightData> accentLights;
+    bool accentLighting = SceneConfig::ACCENT_LIGHTS;
+    bool accentKeyWasDown = false;
+    {
+        const glm::vec3 accentColors[] = {{1.0f, 0.55f, 0.25f}, {0.3f, 0.5f, 1.0f}, {0.9f, 0.3f, 0.6f}, {0.4f, 0.9f, 0.5f}};
+        const struct { int side; glm::vec3 normal; } walls[] = {
+            {Room::DOOR_FRONT, {0.0f, 0.0f, 1.0f}},
+            {Room::DOOR_BACK, {0.0f, 0.0f, -1.0f}},
+            {Room::DOOR_LEFT, {-1.0f, 0.0f, 0.0f}},
+            {Room::DOOR_RIGHT, {1.0f, 0.0f, 0.0f}},
+        };
+        const int perWall = SceneConfig::ACCENT_LIGHTS_PER_WALL;
+        for (size_t ri = 0; ri < roomTransforms.size() && ri < rooms.size(); ++ri)
+        {
+            for (const auto &wall : walls)
+            {
+                const glm::vec3 along = glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), wall.normal);
+                for (int k = 0; k < perWall; ++k)
+                {
+                    const float t = -Room::HALF_EXTENT + 1.0f + k * (2.0f * Room::HALF_EXTENT - 2.0f) / (perWall - 1);
+                    if ((rooms[ri].get_door_mask() & wall.side) && std::fabs(t) < Room::DOOR_WIDTH * 0.5f + 0.5f)
+                        continue;
+                    const glm::vec3 local = wall.normal * (Room::HALF_EXTENT - 0.5f) + along * t + glm::vec3(0.0f, Room::FLOOR_Y + 0.3f, 0.0f);
+                    const glm::vec3 color = accentColors[accentLights.size() % 4];
+                    PointLightData light;
+                    light.position = roomTransforms[ri] * glm::vec4(local, 1.0f);
+                    light.diffuse = glm::vec4(color * 0.6f, 0.0f);
+                    light.specular = glm::vec4(color * 0.3f, 0.0f);
+                    light.attenuation = glm::vec4{1.0f, 0.7f, 20.0f, 0.0f};
+                    accentLights.push_back(light);
+                }
+            }
+        }
+    }
 
-        glm::vec3(30.0f, -2.0f, -45.0f),
-        glm::vec3(-40.0f, -2.0f, -35.0f),
+    // Lights are assigned to a 16x9x24 froxel grid of the camera view. F5
+    // switches to a single cluster, where every pixel walks every light in
+    // view, for comparison.
+    LightClusters lightClusters(SceneConfig::CLUSTER_TILES_X, SceneConfig::CLUSTER_TILES_Y, SceneConfig::CLUSTER_SLICES);
+    LightClusters unclusteredLights(1, 1, 1);
+    bool clusteredLighting = true;
+    bool clusterKeyWasDown = false;
+    double clusterBuildMs = 0.0;
+
+    // Surface programs, one variant per [normal map][point shadow], for the
+    // forward and the G-buffer pass. Each draw takes the cheapest variant
+    // that covers it: the exterior floor ignores the point shadow, and
+    // models without a normal map skip the normal map fetch. Sampler units
+    // never change, so they are set once per variant.
+    using SurfaceVariants = std::array<std::array<std::shared_ptr<Shader>, 2>, 2>;
+    SurfaceVariants forwardShaders;
+    SurfaceVariants gbufferShaders;
+    for (int normalMap = 0; normalMap < 2; ++normalMap)
+    {
+        for (int pointShadows = 0; pointShadows < 2; ++pointShadows)
+        {
+            const ShaderDefines defines = surface_defines(normalMap, pointShadows);
+            auto &forward = forwardShaders[normalMap][pointShadows];
+            forward = ShaderCache::get(Data::vertex_shader_path, Data::fragment_shader_path, defines);
+            frameUniforms->attach(*forward);
+            lightsUniforms->attach(*forward);
+            shadowsUniforms->attach(*forward);
+            forward->use();
+            glUniform1i(forward->get_uniform_texture_sampler_id(), 0);
+            glUniform1i(forward->get_uniform_location("normal_sampler"_uniform), 1);
+            glUniform1i(forward->get_uniform_location("shadowMap"_uniform), 3);
+            glUniform1i(forward->get_uniform_location("spotShadowAtlas"_uniform), 4);
+            glUniform1i(forward->get_uniform_location("lightData"_uniform), 5);
+            glUniform1i(forward->get_uniform_location("clusterLights"_uniform), 6);
+            glUniform1i(forward->get_uniform_location("lightIndices"_uniform), 7);
+
+            auto &gbufferShader = gbufferShaders[normalMap][pointShadows];
+            gbufferShader = ShaderCache::get(Data::vertex_shader_path, Data::root_path / "shaders" / "gbuffer.frag", defines);
+            frameUniforms->attach(*gbufferShader);
+            gbufferShader->use();
+            glUniform1i(gbufferShader->get_uniform_texture_sampler_id(), 0);
+            glUniform1i(gbufferShader->get_uniform_location("normal_sampler"_uniform), 1);
+        }
+    }
 
-        glm::vec3(55.0f, -2.0f, -20.0f),
-        glm::vec3(-50.0f, -2.0f, 20.0f),
+    deferredShader->use();
+    glUniform1i(deferredShader->get_uniform_location("gAlbedo"_uniform), 0);
+    glUniform1i(deferredShader->get_uniform_location("gNormal"_uniform), 1);
+    glUniform1i(deferredShader->get_uniform_location("gDepth"_uniform), 2);
+    glUniform1i(deferredShader->get_uniform_location("shadowMap"_uniform), 3);
+    glUniform1i(deferredShader->get_uniform_location("spotShadowAtlas"_uniform), 4);
+    glUniform1i(deferredShader->get_uniform_location("lightData"_uniform), 5);
+    glUniform1i(deferredShader->get_uniform_location("clusterLights"_uniform), 6);
+    glUniform1i(deferredShader->get_uniform_location("lightIndices"_uniform), 7);
+
+    ShadowsBlock shadows;
+    shadows.far_plane = SHADOW_FAR;
+    shadows.shadow_radius = 0.12f;
+
+    FrameBlock frame;
+
+    // F2 switches the point shadow between six passes and one layered pass.
+    // Submission time is accumulated per path so F1 can compare them.
+    bool layeredShadows = false;
+    bool layeredKeyWasDown = false;
+    double pointShadowSubmitMs[2] = {0.0, 0.0};
+    std::size_t pointShadowUpdates[2] = {0, 0};
+
+    // Spot lights are fixed to the room ceilings, so their shadow views are
+    // computed once
+    const float spotFov = spotOuterDeg * 2.0f;
+    const float near_plane_spot = 0.1f;
+    const float far_plane_spot = 25.0f;
+    std::vector<glm::vec3> spotPositions(SPOT_COUNT);
+    std::vector<glm::mat4> spotLightSpaces(SPOT_COUNT);
+    std::vector<Cone> spotCones(SPOT_COUNT);
+    for (int si = 0; si < SPOT_COUNT && si < (int)roomTransforms.size(); ++si)
+    {
+        glm::vec3 spos = glm::vec3(roomTransforms[si] * glm::vec4(0.0f, 7.5f, 0.0f, 1.0f));
+        glm::vec3 sdir = glm::vec3(0.0f, -1.0f, 0.0f);
+
+        glm::mat4 lightProj = glm::perspective(glm::radians(spotFov), 1.0f, near_plane_spot, far_plane_spot);
+        glm::vec3 up = fabs(sdir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightView = glm::lookAt(spos, spos + sdir, up);
+
+        spotPositions[si] = spos;
+        spotLightSpaces[si] = lightProj * lightView;
+        // The shadow frustum's square cross-section reaches past the cone
+        // in the corners, so bound it by the half diagonal
+        spotCones[si].update(spos, sdir, std::atan(std::sqrt(2.0f) * std::tan(glm::radians(spotFov * 0.5f))), far_plane_spot);
+        if (si < ShadowsBlock::MAX_SPOT_SHADOWS)
+            shadows.spot_light_space[si] = spotLightSpaces[si];
+    }
+
+    // Static casters (rooms and props) are rendered into a map only when its
+    // light moves; the result is cached and dynamic casters are drawn over a
+    // restored copy when something moves inside the light's volume
+    ShadowCache pointShadowCache(GL_TEXTURE_CUBE_MAP, shadowCubemap.get_depth_cubemap_id(), SHADOW_SIZE);
+    std::vector<std::unique_ptr<ShadowCache>> spotShadowCaches(SPOT_COUNT);
+    auto placeSpotShadow = [&](int si) {
+        const ShadowAtlas::Tile &tile = spotAtlas.get_tile(si);
+        spotShadowCaches[si] = std::make_unique<ShadowCache>(GL_TEXTURE_2D, spotAtlas.get_texture_id(), tile.size, tile.x, tile.y);
+        if (si < ShadowsBlock::MAX_SPOT_SHADOWS)
+            shadows.spot_shadow_tiles[si] = spotAtlas.get_rect(si);
+    };
+    for (int si = 0; si < SPOT_COUNT; ++si)
+        placeSpotShadow(si);
+
+    // Render `set` into the point shadow cubemap. The static layer clears
+    // the map and includes the rooms; a dynamic layer draws over it.
+    auto renderPointShadow = [&](const glm::vec3 &light_pos, const Scene::VisibleSet &set, bool staticLayer) {
+        float near_plane = 0.1f;
+        glm::mat4 shadow_proj = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, SHADOW_FAR);
+        auto shadow_views = shadowCubemap.get_shadow_views(light_pos);
+        auto shadow_matrices = shadowCubemap.get_shadow_matrices(light_pos, near_plane);
+
+        glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+
+        if (layeredShadows)
+        {
+            // One traversal: the geometry shader replicates every
+            // triangle into the faces it touches
+            layeredDepthShader->use();
+            shadowCubemap.attach_layered();
+            if (staticLayer)
+                glClear(GL_DEPTH_BUFFER_BIT);
+
+            glUniformMatrix4fv(layeredDepthShader->get_uniform_location("shadowMatrices"_uniform), 6, GL_FALSE, glm::value_ptr(shadow_matrices[0]));
+            glUniform3fv(layeredDepthShader->get_uniform_location("lightPos"_uniform), 1, glm::value_ptr(light_pos));
+            glUniform1f(layeredDepthShader->get_uniform_location("far_plane"_uniform), SHADOW_FAR);
+
+            for (size_t ri = 0; staticLayer && ri < rooms.size() && ri < roomTransforms.size(); ++ri)
+            {
+                if (glm::length(roomBounds[ri].center - light_pos) <= SHADOW_FAR + roomBounds[ri].radius)
+                {
+                    rooms[ri].render_for_depth(layeredDepthShader, roomTransforms[ri]);
+                }
+            }
+
+            scene.draw(set, layeredDepthShader, true);
+            shadowCastersDrawn += set.instances.size();
+        }
+        else
+        {
+            depthShader->use();
+            scene.gather_bounds(set, casterBounds);
+            for (unsigned int face = 0; face < 6; ++face)
+            {
+                shadowCubemap.attach_face(face);
+                if (staticLayer)
+                    glClear(GL_DEPTH_BUFFER_BIT);
+
+                glUniformMatrix4fv(depthShader->get_uniform_projection_id(), 1, GL_FALSE, glm::value_ptr(shadow_proj));
+                glUniformMatrix4fv(depthShader->get_uniform_view_id(), 1, GL_FALSE, glm::value_ptr(shadow_views[face]));
+                glUniform3fv(depthShader->get_uniform_location("lightPos"_uniform), 1, glm::value_ptr(light_pos));
+                glUniform1f(depthShader->get_uniform_location("far_plane"_uniform), SHADOW_FAR);
+
+                // Each face only draws what its 90 degree frustum contains
+                Frustum faceFrustum;
+                faceFrustum.update(shadow_matrices[face]);
+
+                for (size_t ri = 0; staticLayer && ri < rooms.size() && ri < roomTransforms.size(); ++ri)
+                {
+                    if (faceFrustum.isAABBInFrustum(roomBounds[ri].min, roomBounds[ri].max))
+                    {
+                        rooms[ri].render_for_depth(depthShader, roomTransforms[ri]);
+                    }
+                }
+
+                faceFrustum.cullAABBs(casterBounds, faceCasters);
+                scene.select(set, faceCasters, casters);
+                scene.draw(casters, depthShader, true);
+                shadowCastersDrawn += casters.instances.size();
+            }
+        }
+        glDisable(GL_CULL_FACE);
     };
 
-    const float tree_scale = 2.0f;
-    const float tree_radius = 3.0f;
+    // Same for spot light `si`
+    auto renderSpotShadow = [&](int si, const Scene::VisibleSet &set, bool staticLayer) {
+        spotAtlas.begin(si, staticLayer);
+        glDisable(GL_CULL_FACE);
+
+        spotDepthShader->use();
+        glUniformMatrix4fv(spotDepthShader->get_uniform_location("lightSpaceMatrix"_uniform), 1, GL_FALSE, glm::value_ptr(spotLightSpaces[si]));
+
+        for (size_t ri = 0; staticLayer && ri < rooms.size() && ri < roomTransforms.size(); ++ri)
+        {
+            if (spotCones[si].isSphereInCone(roomBounds[ri].center, roomBounds[ri].radius))
+            {
+                rooms[ri].render_for_depth(spotDepthShader, roomTransforms[ri]);
+            }
+        }
+
+        scene.draw(set, spotDepthShader, true);
+        shadowCastersDrawn += set.instances.size();
+        // The scissor would also clip the cache's blits
+        spotAtlas.end();
+    };
+
+    // At most 8 faces per frame: the cubemap (6) plus two spots, so a full
+    // refresh is spread over two frames instead of spiking one
+    ShadowScheduler shadowScheduler(8);
+    const std::size_t pointShadowLight = shadowScheduler.add_light("point light", 6);
+    std::vector<std::size_t> spotShadowLights;
+    for (int si = 0; si < SPOT_COUNT; ++si)
+        spotShadowLights.push_back(shadowScheduler.add_light("spot " + std::to_string(si), 1));
+
+    // Rough screen coverage of a light's volume: about 1 with the camera
+    // inside it, falling off with distance, and cut when it is off-screen
+    auto lightImportance = [&](const glm::vec3 &position, float range) {
+        float distance = glm::length(camera.get_position() - position);
+        float coverage = range / std::max(distance, range);
+        return frustum.isSphereInFrustum(position, range) ? coverage : 0.25f * coverage;
+    };
+
+    // Side wanted for a spot's atlas tile. The current side is kept while the
+    // light's importance stays near its band, so a camera hovering at a
+    // threshold does not move tiles (and re-render them) every frame.
+    auto spotTileSize = [&](int si) {
+        const GLsizei current = spotAtlas.get_tile(si).size;
+        const float target = lightImportance(spotPositions[si], far_plane_spot) * spotAtlas.get_max_tile();
+        if (target >= 0.8f * current && target < 2.5f * current)
+            return current;
+        return static_cast<GLsizei>(target);
+    };
+    std::vector<GLsizei> spotTileRequests(SPOT_COUNT);
+    std::vector<ShadowAtlas::Tile> previousTiles(SPOT_COUNT);
+
+    // Recent frame times, for the percentiles printed by F1
+    std::vector<float> frameTimes;
+    std::size_t frameTimeCursor = 0;
+    constexpr std::size_t FRAME_TIME_HISTORY = 600;
+
+    // Benchmark: every path renders the same views, four headings in each
+    // room, after a warmup that lets the query results of the previous path
+    // drain. Paths are selected through the F4 and F6 toggles.
+    struct BenchmarkPath
+    {
+        const char *name;
+        bool deferred;
+        bool prepass;
+        GpuQuery *timer;
+    };
+    const BenchmarkPath benchmarkPaths[] = {
+        {"forward", false, false, &forwardTime},
+        {"forward, depth prepass", false, true, &forwardTime},
+        {"deferred", true, false, &deferredTime},
+    };
+    constexpr std::size_t BENCHMARK_WARMUP = 30;
+    constexpr std::size_t BENCHMARK_FRAMES_PER_VIEW = 20;
+    const std::size_t benchmarkViews = roomTransforms.size() * 4;
+    const std::size_t benchmarkFramesPerPath = BENCHMARK_WARMUP + benchmarkViews * BENCHMARK_FRAMES_PER_VIEW;
+    std::size_t benchmarkFrame = 0;
+    double benchmarkFrameTime = 0.0;
+    std::vector<std::string> benchmarkResults;
+
+    // Every program is created by now
+    std::cout << "Shader programs: " << Shader::get_binary_hits() << " loaded from the binary cache in "
+              << Shader::get_binary_hit_ms() << " ms, " << Shader::get_binary_misses() << " compiled in "
+              << Shader::get_binary_miss_ms() << " ms" << std::endl;
+
+    bool statsKeyWasDown = false;
+    Shader::reset_lookup_counters();
+    GLState::reset_counters();
 
     while (!main_window->should_be_closed())
     {
@@ -462,15 +917,53 @@ int main()
         GLfloat dt = now - last_time;
         last_time = now;
 
+        if (frameTimes.size() < FRAME_TIME_HISTORY)
+            frameTimes.push_back(dt);
+        else
+            frameTimes[frameTimeCursor] = dt;
+        frameTimeCursor = (frameTimeCursor + 1) % FRAME_TIME_HISTORY;
+
         glfwPollEvents();
 
         glm::mat4 view = camera.get_view_matrix();
         glm::mat4 viewProj = projection * view;
         frustum.update(viewProj);
+        portals.update(viewProj, camera.get_position());
+
+        // Camera pass only; shadow views cull against their own volumes
+        scene.cull([&](const Bounds &bounds) {
+            if (!cullingEnabled)
+                return true;
+            return portalCulling ? portals.is_box_visible(bounds.min, bounds.max) : frustum.isAABBInFrustum(bounds.min, bounds.max);
+        }, camera_visible);
 
         glEnable(GL_DEPTH_TEST);
-        camera.handle_keys(main_window->get_keys());
-        camera.handle_mouse(main_window->get_x_change(), main_window->get_y_change());
+        const BenchmarkPath *benchmarkPath = nullptr;
+        std::size_t benchmarkStep = 0;
+        if (benchmark)
+        {
+            benchmarkPath = &benchmarkPaths[benchmarkFrame / benchmarkFramesPerPath];
+            benchmarkStep = benchmarkFrame % benchmarkFramesPerPath;
+            if (benchmarkStep == BENCHMARK_WARMUP)
+            {
+                benchmarkPath->timer->reset_totals();
+                benchmarkFrameTime = 0.0;
+            }
+            else if (benchmarkStep > BENCHMARK_WARMUP)
+            {
+                benchmarkFrameTime += dt;
+            }
+            const std::size_t viewIndex = benchmarkStep < BENCHMARK_WARMUP ? 0 : (benchmarkStep - BENCHMARK_WARMUP) / BENCHMARK_FRAMES_PER_VIEW;
+            const glm::vec3 eye = glm::vec3(roomTransforms[viewIndex / 4] * glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+            camera.set_pose(eye, -10.0f, -90.0f + 90.0f * static_cast<float>(viewIndex % 4));
+            deferredShading = benchmarkPath->deferred;
+            depthPrepass = benchmarkPath->prepass;
+        }
+        else
+        {
+            camera.handle_keys(main_window->get_keys());
+            camera.handle_mouse(main_window->get_x_change(), main_window->get_y_change());
+        }
         camera.update(dt);
 
         const auto &keys = main_window->get_keys();
@@ -498,775 +991,403 @@ int main()
             prevLp = lp;
         }
 
-        // Shadow passes (ORIGINAL)
-        bool updateShadowsThisFrame = (shadowUpdateCounter % SHADOW_UPDATE_INTERVAL == 0);
-        shadowUpdateCounter++;
+        const bool layeredKeyDown = keys[GLFW_KEY_F2];
+        if (layeredKeyDown && !layeredKeyWasDown)
+        {
+            layeredShadows = !layeredShadows;
+            std::cout << "Point shadow: " << (layeredShadows ? "single layered pass" : "six passes") << std::endl;
+        }
+        layeredKeyWasDown = layeredKeyDown;
 
-        // --- Shadow pass for the single point light ---
-        if (enableShadows && updateShadowsThisFrame)
+        const bool portalKeyDown = keys[GLFW_KEY_F3];
+        if (portalKeyDown && !portalKeyWasDown)
         {
-            glm::vec3 light_pos = ceilingLight.get_position();
-            depthShader->use();
-            float near_plane = 0.1f;
-            glm::mat4 shadow_proj = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, SHADOW_FAR);
-            auto shadow_views = shadowCubemap.get_shadow_views(light_pos);
+            portalCulling = !portalCulling;
+            std::cout << "Camera culling: " << (portalCulling ? "portals" : "view frustum") << std::endl;
+        }
+        portalKeyWasDown = portalKeyDown;
 
-            glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
-            glBindFramebuffer(GL_FRAMEBUFFER, shadowCubemap.get_fbo());
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
+        const bool prepassKeyDown = keys[GLFW_KEY_F4];
+        if (prepassKeyDown && !prepassKeyWasDown)
+        {
+            depthPrepass = !depthPrepass;
+            forwardTime.reset_totals();
+            std::cout << "Depth prepass: " << (depthPrepass ? "on" : "off") << std::endl;
+        }
+        prepassKeyWasDown = prepassKeyDown;
 
-            for (unsigned int face = 0; face < 6; ++face)
-            {
-                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, shadowCubemap.get_depth_cubemap_id(), 0);
-                glClear(GL_DEPTH_BUFFER_BIT);
+        const bool clusterKeyDown = keys[GLFW_KEY_F5];
+        if (clusterKeyDown && !clusterKeyWasDown)
+        {
+            clusteredLighting = !clusteredLighting;
+            std::cout << "Lighting: " << (clusteredLighting ? "clustered" : "every light in view per pixel") << std::endl;
+        }
+        clusterKeyWasDown = clusterKeyDown;
 
-                glUniformMatrix4fv(depthShader->get_uniform_projection_id(), 1, GL_FALSE, glm::value_ptr(shadow_proj));
-                glUniformMatrix4fv(depthShader->get_uniform_view_id(), 1, GL_FALSE, glm::value_ptr(shadow_views[face]));
-                glUniform3fv(glGetUniformLocation(depthShader->get_program_id(), "lightPos"), 1, glm::value_ptr(light_pos));
-                glUniform1f(glGetUniformLocation(depthShader->get_program_id(), "far_plane"), SHADOW_FAR);
+        const bool deferredKeyDown = keys[GLFW_KEY_F6];
+        if (deferredKeyDown && !deferredKeyWasDown && !benchmark)
+        {
+            deferredShading = !deferredShading;
+            forwardTime.reset_totals();
+            deferredTime.reset_totals();
+            std::cout << "Shading: " << (deferredShading ? "deferred" : "forward") << std::endl;
+        }
+        deferredKeyWasDown = deferredKeyDown;
 
-                for (size_t ri = 0; ri < rooms.size() && ri < roomTransforms.size(); ++ri)
+        const bool accentKeyDown = keys[GLFW_KEY_F7];
+        if (accentKeyDown && !accentKeyWasDown && !benchmark)
+        {
+            accentLighting = !accentLighting;
+            std::cout << "Accent lights: " << (accentLighting ? std::to_string(accentLights.size()) : "off") << std::endl;
+        }
+        accentKeyWasDown = accentKeyDown;
+
+        // Shadow maps are only re-rendered when their light moved or a
+        // dynamic caster changed inside their volume; a static scene costs
+        // nothing here. Dirty lights are queued and the scheduler hands out
+        // a per-frame face budget, closest and most visible lights first.
+        shadowCastersDrawn = 0;
+        if (enableShadows)
+        {
+            glm::vec3 light_pos = ceilingLight.get_position();
+            auto inPointRange = [&](const Bounds &bounds) {
+                return glm::length(bounds.center - light_pos) <= SHADOW_FAR + bounds.radius;
+            };
+            if (pointShadowCache.is_stale(light_pos) || scene.changed(inPointRange))
+                shadowScheduler.request(pointShadowLight, lightImportance(light_pos, SHADOW_FAR));
+
+            // Relayout the atlas when the tile sizes wanted change. Lights whose
+            // tile moved get a new (empty) cache and must be refreshed this
+            // frame, over the face budget: their new tile holds nothing, or
+            // another light's depth.
+            for (int si = 0; si < SPOT_COUNT; ++si)
+            {
+                spotTileRequests[si] = spotTileSize(si);
+                previousTiles[si] = spotAtlas.get_tile(si);
+            }
+            if (spotAtlas.pack(spotTileRequests))
+            {
+                for (int si = 0; si < SPOT_COUNT; ++si)
                 {
-                    glm::vec3 roomCenter = glm::vec3(roomTransforms[ri] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-                    float roomRadius = 15.0f;
-                    if (frustum.isSphereInFrustum(roomCenter, roomRadius))
+                    const ShadowAtlas::Tile &tile = spotAtlas.get_tile(si);
+                    if (tile.x != previousTiles[si].x || tile.y != previousTiles[si].y || tile.size != previousTiles[si].size)
                     {
-                        rooms[ri].render_for_depth(depthShader, roomTransforms[ri]);
+                        placeSpotShadow(si);
+                        shadowScheduler.request(spotShadowLights[si], lightImportance(spotPositions[si], far_plane_spot), true);
                     }
                 }
+            }
+
+            for (int si = 0; si < (int)roomTransforms.size() && si < SPOT_COUNT; ++si)
+            {
+                auto inCone = [&](const Bounds &bounds) {
+                    return spotCones[si].isSphereInCone(bounds.center, bounds.radius);
+                };
+                if (spotShadowCaches[si]->is_stale(spotPositions[si]) || scene.changed(inCone))
+                    shadowScheduler.request(spotShadowLights[si], lightImportance(spotPositions[si], far_plane_spot));
+            }
+            scene.clear_changes();
 
-                if (!imported_models.empty())
+            const auto &refresh = shadowScheduler.schedule();
+            for (std::size_t light : refresh)
+            {
+                if (light == pointShadowLight)
                 {
-                    const float modelScale = 2.0f;
-                    const float floorY = -2.0f;
-                    std::vector<glm::vec3> positions = {
-                        glm::vec3(0.0f, floorY, 28.5f), glm::vec3(0.0f, floorY, -28.5f),
-                        glm::vec3(28.5f, floorY, 0.0f), glm::vec3(-28.5f, floorY, 0.0f)};
-                    std::vector<float> rotations = {0.0f, glm::pi<float>(), glm::radians(-90.0f), glm::radians(90.0f)};
-
-                    for (auto &r : imported_models)
-                    {
-                        for (size_t i = 0; i < positions.size(); ++i)
-                        {
-                            glm::vec3 tablePos = positions[i];
-                            float tableRadius = 5.0f;
-                            float distToLight = glm::length(tablePos - light_pos);
-                            if (distToLight > SHADOW_FAR + 5.0f)
-                                continue;
-
-                            if (!cullingEnabled || frustum.isSphereInFrustum(tablePos, tableRadius))
-                            {
-                                glm::mat4 modelMat{1.0f};
-                                modelMat = glm::translate(modelMat, positions[i]);
-                                modelMat = glm::rotate(modelMat, rotations[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                                modelMat = glm::scale(modelMat, glm::vec3(modelScale));
-                                modelMat = modelMat * r.transform;
-                                glUniformMatrix4fv(depthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                r.mesh->render();
-                            }
-                        }
-                    }
+                    const auto submitStart = std::chrono::steady_clock::now();
 
-                    if (!potted_models.empty())
+                    // Casters come from the whole scene, not the camera view: an
+                    // off-screen object can still throw a visible shadow
+                    if (pointShadowCache.is_stale(light_pos))
                     {
-                        std::vector<glm::vec3> potPositions = {
-                            glm::vec3(8.0f, floorY, 8.0f), glm::vec3(-8.0f, floorY, 8.0f),
-                            glm::vec3(8.0f, floorY, -8.0f), glm::vec3(-8.0f, floorY, -8.0f)};
-                        std::vector<float> potRot = {0.0f, glm::pi<float>(), glm::radians(90.0f), glm::radians(-90.0f)};
-                        const float potScale = 4.0f;
-
-                        for (auto &pr : potted_models)
-                        {
-                            for (size_t i = 0; i < potPositions.size(); ++i)
-                            {
-                                if (!cullingEnabled || frustum.isSphereInFrustum(potPositions[i], 2.0f))
-                                {
-                                    float dist = glm::length(potPositions[i] - light_pos);
-                                    if (dist > SHADOW_FAR + 5.0f)
-                                        continue;
-                                    glm::mat4 modelMat{1.0f};
-                                    modelMat = glm::translate(modelMat, potPositions[i]);
-                                    modelMat = glm::rotate(modelMat, potRot[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                                    modelMat = glm::scale(modelMat, glm::vec3(potScale));
-                                    modelMat = modelMat * pr.transform;
-                                    glUniformMatrix4fv(depthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                    pr.mesh->render();
-                                }
-                            }
-                        }
+                        scene.cull(false, inPointRange, lightCasters);
+                        renderPointShadow(light_pos, lightCasters, true);
+                        pointShadowCache.store(light_pos);
                     }
-
-                    if (!picture_models.empty())
+                    else
                     {
-                        const float pictureYOffset = 3.5f;
-                        const float pictureShift = 4.0f;
-                        const float wallDist = 9.8f;
-                        std::vector<glm::vec3> picPositions = {
-                            glm::vec3(pictureShift, floorY + pictureYOffset, wallDist),
-                            glm::vec3(pictureShift, floorY + pictureYOffset, -wallDist),
-                            glm::vec3(wallDist, floorY + pictureYOffset, pictureShift),
-                            glm::vec3(-wallDist, floorY + pictureYOffset, pictureShift)};
-                        std::vector<float> picRot = {glm::pi<float>(), 0.0f, glm::radians(270.0f), glm::radians(90.0f)};
-                        const float picScale = 4.0f;
-
-                        renderModelSpotShadow(picture_models, picPositions, picRot, cullingEnabled, frustum, 2.0f, picScale, depthShader);
-
-                        if (!picture2_models.empty())
-                        {
-                            std::vector<glm::vec3> pic2Positions = {
-                                glm::vec3(-pictureShift, floorY + pictureYOffset, wallDist),
-                                glm::vec3(-pictureShift, floorY + pictureYOffset, -wallDist),
-                                glm::vec3(wallDist, floorY + pictureYOffset, -pictureShift),
-                                glm::vec3(-wallDist, floorY + pictureYOffset, -pictureShift)};
-                            renderModelSpotShadow(picture2_models, pic2Positions, picRot, cullingEnabled, frustum, 2.0f, picScale, depthShader);
-                        }
+                        pointShadowCache.restore();
                     }
 
-                    float tableHeight = 0.0f;
-                    for (auto &r : imported_models)
-                    {
-                        tableHeight = std::max(tableHeight, r.src_max.y - r.src_min.y);
-                    }
-                    tableHeight *= modelScale;
+                    scene.cull(true, inPointRange, dynamicCasters);
+                    if (!dynamicCasters.instances.empty())
+                        renderPointShadow(light_pos, dynamicCasters, false);
 
-                    std::vector<float> perPropFootprint = {0.15f, 0.6f, 0.8f, 1.5f};
-                    for (size_t i = 0; i < prop_models.size() && i < positions.size(); ++i)
-                    {
-                        auto &group = prop_models[i];
-                        glm::vec3 basePos = positions[i];
-                        basePos.y = floorY + tableHeight + 0.02f;
-                        for (auto &pr : group)
-                        {
-                            if (!cullingEnabled || frustum.isSphereInFrustum(basePos, 1.0f))
-                            {
-                                glm::vec3 srcSize = pr.src_max - pr.src_min;
-                                glm::vec3 srcCenter = (pr.src_min + pr.src_max) * 0.5f;
-                                float footprintDim = std::max(0.001f, std::max(srcSize.x, srcSize.z));
-                                float target = (i < perPropFootprint.size()) ? perPropFootprint[i] : 0.6f;
-                                float scaleUniform = target / footprintDim;
-                                scaleUniform = std::clamp(scaleUniform, 0.02f, 10.0f);
-
-                                glm::mat4 modelMat{1.0f};
-                                modelMat = glm::translate(modelMat, basePos);
-                                modelMat = glm::scale(modelMat, glm::vec3(scaleUniform));
-                                glm::vec3 centerXZ = glm::vec3(srcCenter.x, 0.0f, srcCenter.z);
-                                modelMat = modelMat * pr.transform * glm::translate(glm::mat4(1.0f), -centerXZ);
-
-                                glUniformMatrix4fv(depthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                pr.mesh->render();
-                            }
-                        }
-                    }
+                    // CPU time spent submitting the pass (the GPU work is not waited on)
+                    const std::chrono::duration<double, std::milli> submitTime = std::chrono::steady_clock::now() - submitStart;
+                    pointShadowSubmitMs[layeredShadows] += submitTime.count();
+                    ++pointShadowUpdates[layeredShadows];
+                    continue;
                 }
 
-                const float defaultStatueScale = 12.0f;
-                const float cannonScale = 3.0f;
-                const float coffeeScale = 2.0f;
-                const float floorY = -2.0f;
-
-                if (!cat_statue.empty())
-                {
-                    renderModelPointShadow(cat_statue, glm::vec3(0.0f, floorY, 0.0f), cullingEnabled, frustum, 8.0f, defaultStatueScale, depthShader);
-                }
-                if (!cannon_statue.empty())
-                {
-                    renderModelPointShadow(cannon_statue, glm::vec3(20.0f, floorY, 0.0f), cullingEnabled, frustum, 5.0f, cannonScale, depthShader);
-                }
-                if (!cart_statue.empty())
-                {
-                    renderModelPointShadow(cart_statue, glm::vec3(-20.0f, floorY, 0.0f), cullingEnabled, frustum, 4.0f, coffeeScale, depthShader);
-                }
-                if (!drill_statue.empty())
+                const int si = static_cast<int>(light - spotShadowLights[0]);
+                auto inCone = [&](const Bounds &bounds) {
+                    return spotCones[si].isSphereInCone(bounds.center, bounds.radius);
+                };
+                if (spotShadowCaches[si]->is_stale(spotPositions[si]))
                 {
-                    renderModelPointShadow(drill_statue, glm::vec3(0.0f, floorY, 20.0f), cullingEnabled, frustum, 8.0f, defaultStatueScale, depthShader);
+                    scene.cull(false, inCone, casters);
+                    renderSpotShadow(si, casters, true);
+                    spotShadowCaches[si]->store(spotPositions[si]);
                 }
-                if (!horse_statue.empty())
+                else
                 {
-                    renderModelPointShadow(horse_statue, glm::vec3(0.0f, floorY, -20.0f), cullingEnabled, frustum, 8.0f, defaultStatueScale, depthShader);
-                }
-                if (!tree_models.empty())
-                {
-                    for (const auto &position : tree_positions)
-                    {
-                        renderModelPointShadow(tree_models, position, cullingEnabled, frustum, tree_radius, tree_scale, depthShader);
-                    }
+                    spotShadowCaches[si]->restore();
                 }
 
-                if (!potted_plant_02.empty())
-                {
-                    const float potScale = 4.0f;
-                    std::vector<glm::vec3> outerRoomCenters = {
-                        glm::vec3(20.0f, 0.0f, 0.0f), glm::vec3(-20.0f, 0.0f, 0.0f),
-                        glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, -20.0f)};
-                    std::vector<glm::vec3> cornerOffsets = {
-                        glm::vec3(8.0f, 0.0f, 8.0f), glm::vec3(-8.0f, 0.0f, 8.0f),
-                        glm::vec3(8.0f, 0.0f, -8.0f), glm::vec3(-8.0f, 0.0f, -8.0f)};
-
-                    for (const auto &center : outerRoomCenters)
-                    {
-                        for (const auto &offset : cornerOffsets)
-                        {
-                            glm::vec3 pos = center + offset;
-                            pos.y = floorY;
-                            if (!cullingEnabled || frustum.isSphereInFrustum(pos, 2.0f))
-                            {
-                                glm::mat4 modelMat{1.0f};
-                                modelMat = glm::translate(modelMat, pos);
-                                modelMat = glm::scale(modelMat, glm::vec3(potScale));
-                                for (auto &r : potted_plant_02)
-                                {
-                                    glm::mat4 m = modelMat * r.transform;
-                                    glUniformMatrix4fv(depthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(m));
-                                    r.mesh->render();
-                                }
-                            }
-                        }
-                    }
-                }
+                scene.cull(true, inCone, dynamicCasters);
+                if (!dynamicCasters.instances.empty())
+                    renderSpotShadow(si, dynamicCasters, false);
+            }
+
+            if (!refresh.empty())
+            {
+                GLState::bind_framebuffer(0);
+                glViewport(0, 0, main_window->get_buffer_width(), main_window->get_buffer_height());
             }
-            glDisable(GL_CULL_FACE);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            glViewport(0, 0, main_window->get_buffer_width(), main_window->get_buffer_height());
         }
 
-        // --- Spot shadow pass ---
-        if (enableShadows && updateShadowsThisFrame)
-        {
-            const float spotFov = spotOuterDeg * 2.0f;
-            const float near_plane_spot = 0.1f;
-            const float far_plane_spot = 25.0f;
+        // Per-frame uniform data, one buffer update per block
+        frame.view = camera.get_view_matrix();
+        frame.projection = projection;
+        frame.view_position = glm::vec4{camera.get_position(), 1.0f};
 
-            for (int si = 0; si < (int)roomTransforms.size() && si < (int)spotDepthFBOs.size(); ++si)
-            {
-                glm::vec3 spos = glm::vec3(roomTransforms[si] * glm::vec4(0.0f, 7.5f, 0.0f, 1.0f));
-                glm::vec3 sdir = glm::vec3(0.0f, -1.0f, 0.0f);
+        // The point light (with the shadow cubemap), the spots (with their
+        // atlas tiles) and the accent lights, assigned to this view's clusters
+        const auto clusterStart = std::chrono::steady_clock::now();
+        LightClusters &clusters = clusteredLighting ? lightClusters : unclusteredLights;
+        clusters.clear();
+        for (size_t i = 0; i < lightbulbs.size(); ++i)
+        {
+            PointLightData data;
+            lightbulbs[i].write_light(data);
+            clusters.add(data, i == 0 ? 0 : -1);
+        }
+        for (size_t si = 0; si < spotLights.size(); ++si)
+            clusters.add(spotLights[si], si < ShadowsBlock::MAX_SPOT_SHADOWS ? static_cast<int>(si) : -1);
+        if (accentLighting)
+        {
+            for (const auto &light : accentLights)
+                clusters.add(light);
+        }
+        clusters.update(frame.view, projection, main_window->get_buffer_width(), main_window->get_buffer_height());
+        clusters.write(lights);
+        clusters.bind(5);
+        clusterBuildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - clusterStart).count();
 
-                glm::mat4 lightProj = glm::perspective(glm::radians(spotFov), 1.0f, near_plane_spot, far_plane_spot);
-                glm::vec3 up = fabs(sdir.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
-                glm::mat4 lightView = glm::lookAt(spos, spos + sdir, up);
-                glm::mat4 lightSpace = lightProj * lightView;
+        frameUniforms->write(frame);
+        lightsUniforms->write(lights);
+        shadowsUniforms->write(shadows);
 
-                glViewport(0, 0, SPOT_SHADOW_RES, SPOT_SHADOW_RES);
-                glBindFramebuffer(GL_FRAMEBUFFER, spotDepthFBOs[si]);
-                glClear(GL_DEPTH_BUFFER_BIT);
-                glDisable(GL_CULL_FACE);
+        glClearColor(0.f, 0.f, 0.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-                spotDepthShader->use();
-                glUniformMatrix4fv(glGetUniformLocation(spotDepthShader->get_program_id(), "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(lightSpace));
+        const bool exteriorVisible = !cullingEnabled || !portalCulling || portals.is_visible(portals.outside());
+        auto roomVisible = [&](size_t i) {
+            return !cullingEnabled || (portalCulling ? portals.is_room_visible(i) : frustum.isAABBInFrustum(roomBounds[i].min, roomBounds[i].max));
+        };
+
+        // Surfaces in view, drawn with the forward or the G-buffer variants
+        auto renderSurfaces = [&](const SurfaceVariants &variants) {
+            // Piso exterior, unless no doorway to the outside is in view
+            if (exteriorVisible)
+                render_exterior_floor(variants[Data::exterior_floor_has_normal_map][0]);
+
+            // Habitaciones y objetos; models without a normal map use the flat variant
+            const std::shared_ptr<Shader> &shader = variants[1][1];
+            const std::shared_ptr<Shader> &flatShader = variants[0][1];
+            for (const auto &program : {flatShader, shader})
+            {
+                program->use();
+                glUniform1i(program->get_uniform_location("dirLightIndex"_uniform), LightsBlock::DIR_LIGHT_INTERIOR);
+            }
 
-                for (size_t ri = 0; ri < rooms.size() && ri < roomTransforms.size(); ++ri)
+            for (size_t i = 0; i < roomTransforms.size() && i < rooms.size(); ++i)
+            {
+                if (roomVisible(i))
                 {
-                    glm::vec3 roomCenter = glm::vec3(roomTransforms[ri] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-                    float roomRadius = 15.0f;
-                    if (frustum.isSphereInFrustum(roomCenter, roomRadius))
-                    {
-                        rooms[ri].render_for_depth(spotDepthShader, roomTransforms[ri]);
-                    }
+                    rooms[i].render(shader, roomTransforms[i]);
                 }
+            }
 
-                if (!imported_models.empty())
-                {
-                    const float modelScale = 2.0f;
-                    const float floorY = -2.0f;
-                    std::vector<glm::vec3> positions = {
-                        glm::vec3(0.0f, floorY, 28.5f), glm::vec3(0.0f, floorY, -28.5f),
-                        glm::vec3(28.5f, floorY, 0.0f), glm::vec3(-28.5f, floorY, 0.0f)};
-                    std::vector<float> rotations = {0.0f, glm::pi<float>(), glm::radians(-90.0f), glm::radians(90.0f)};
-
-                    for (auto &r : imported_models)
-                    {
-                        for (size_t i = 0; i < positions.size(); ++i)
-                        {
-                            glm::vec3 tablePos = positions[i];
-                            float tableRadius = 5.0f;
-                            float distToSpot = glm::length(tablePos - spos);
-                            if (distToSpot > far_plane_spot + 5.0f)
-                                continue;
-
-                            glm::vec3 toObj = glm::normalize(tablePos - spos);
-                            glm::vec3 spotDir = glm::normalize(sdir);
-                            float angleDeg = glm::degrees(acos(glm::clamp(glm::dot(spotDir, toObj), -1.0f, 1.0f)));
-                            if (angleDeg > (spotOuterDeg * 1.2f))
-                                continue;
-
-                            if (!cullingEnabled || frustum.isSphereInFrustum(tablePos, tableRadius))
-                            {
-                                glm::mat4 modelMat{1.0f};
-                                modelMat = glm::translate(modelMat, positions[i]);
-                                modelMat = glm::rotate(modelMat, rotations[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                                modelMat = glm::scale(modelMat, glm::vec3(modelScale));
-                                modelMat = modelMat * r.transform;
-                                glUniformMatrix4fv(spotDepthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                r.mesh->render();
-                            }
-                        }
-                    }
+            glUniform1f(shader->get_uniform_location("material.shininess"_uniform), 32.0f);
+            flatShader->use();
+            glUniform1f(flatShader->get_uniform_location("material.shininess"_uniform), 32.0f);
+            shader->use();
+            scene.draw(camera_visible, shader, false, flatShader);
+        };
 
-                    if (!potted_models.empty())
-                    {
-                        std::vector<glm::vec3> potPositions = {
-                            glm::vec3(8.0f, floorY, 8.0f), glm::vec3(-8.0f, floorY, 8.0f),
-                            glm::vec3(8.0f, floorY, -8.0f), glm::vec3(-8.0f, floorY, -8.0f)};
-                        std::vector<float> potRot = {0.0f, glm::pi<float>(), glm::radians(90.0f), glm::radians(-90.0f)};
-                        const float potScale = 4.0f;
-
-                        for (auto &pr : potted_models)
-                        {
-                            for (size_t i = 0; i < potPositions.size(); ++i)
-                            {
-                                if (!cullingEnabled || frustum.isSphereInFrustum(potPositions[i], 2.0f))
-                                {
-                                    // Skip if far from spotlight origin
-                                    float dist = glm::length(potPositions[i] - spos);
-                                    if (dist > far_plane_spot + 5.0f)
-                                        continue;
-                                    glm::mat4 modelMat{1.0f};
-                                    modelMat = glm::translate(modelMat, potPositions[i]);
-                                    modelMat = glm::rotate(modelMat, potRot[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                                    modelMat = glm::scale(modelMat, glm::vec3(potScale));
-                                    modelMat = modelMat * pr.transform;
-                                    glUniformMatrix4fv(spotDepthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                    pr.mesh->render();
-                                }
-                            }
-                        }
-                    }
+        // Shadow maps: point light cubemap and spot shadow atlas
+        GLState::bind_texture(3, GL_TEXTURE_CUBE_MAP, shadowCubemap.get_depth_cubemap_id());
+        GLState::bind_texture(4, GL_TEXTURE_2D, spotAtlas.get_texture_id());
 
-                    if (!picture_models.empty())
-                    {
-                        const float pictureYOffset = 3.5f;
-                        const float pictureShift = 4.0f;
-                        const float wallDist = 9.8f;
-                        std::vector<glm::vec3> picPositions = {
-                            glm::vec3(pictureShift, floorY + pictureYOffset, wallDist),
-                            glm::vec3(pictureShift, floorY + pictureYOffset, -wallDist),
-                            glm::vec3(wallDist, floorY + pictureYOffset, pictureShift),
-                            glm::vec3(-wallDist, floorY + pictureYOffset, pictureShift)};
-                        std::vector<float> picRot = {glm::pi<float>(), 0.0f, glm::radians(270.0f), glm::radians(90.0f)};
-                        const float picScale = 4.0f;
-
-                        for (auto &pr : picture_models)
-                        {
-                            for (size_t i = 0; i < picPositions.size(); ++i)
-                            {
-                                if (!cullingEnabled || frustum.isSphereInFrustum(picPositions[i], 2.0f))
-                                {
-                                    // Skip if far from spotlight
-                                    float dist = glm::length(picPositions[i] - spos);
-                                    if (dist > far_plane_spot + 5.0f)
-                                        continue;
-
-                                    glm::mat4 modelMat{1.0f};
-                                    modelMat = glm::translate(modelMat, picPositions[i]);
-                                    modelMat = glm::rotate(modelMat, picRot[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                                    modelMat = glm::scale(modelMat, glm::vec3(picScale));
-                                    modelMat = modelMat * pr.transform;
-                                    glUniformMatrix4fv(spotDepthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                    pr.mesh->render();
-                                }
-                            }
-                        }
-
-                        if (!picture2_models.empty())
-                        {
-                            std::vector<glm::vec3> pic2Positions = {
-                                glm::vec3(-pictureShift, floorY + pictureYOffset, wallDist),
-                                glm::vec3(-pictureShift, floorY + pictureYOffset, -wallDist),
-                                glm::vec3(wallDist, floorY + pictureYOffset, -pictureShift),
-                                glm::vec3(-wallDist, floorY + pictureYOffset, -pictureShift)};
-
-                            for (auto &pr : picture2_models)
-                            {
-                                for (size_t i = 0; i < pic2Positions.size(); ++i)
-                                {
-                                    if (!cullingEnabled || frustum.isSphereInFrustum(pic2Positions[i], 2.0f))
-                                    {
-                                        float dist = glm::length(pic2Positions[i] - spos);
-                                        if (dist > far_plane_spot + 5.0f)
-                                            continue;
-
-                                        glm::mat4 modelMat{1.0f};
-                                        modelMat = glm::translate(modelMat, pic2Positions[i]);
-                                        modelMat = glm::rotate(modelMat, picRot[i], glm::vec3(0.0f, 1.0f, 0.0f));
-                                        modelMat = glm::scale(modelMat, glm::vec3(picScale));
-                                        modelMat = modelMat * pr.transform;
-                                        glUniformMatrix4fv(spotDepthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                        pr.mesh->render();
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    float tableHeight = 0.0f;
-                    for (auto &r : imported_models)
-                        tableHeight = std::max(tableHeight, r.src_max.y - r.src_min.y);
-                    tableHeight *= modelScale;
-
-                    std::vector<float> perPropFootprint = {0.15f, 0.6f, 0.8f, 1.5f};
-                    for (size_t i = 0; i < prop_models.size() && i < positions.size(); ++i)
-                    {
-                        auto &group = prop_models[i];
-                        glm::vec3 basePos = positions[i];
-                        basePos.y = floorY + tableHeight + 0.02f;
-                        for (auto &pr : group)
-                        {
-                            if (!cullingEnabled || frustum.isSphereInFrustum(basePos, 1.0f))
-                            {
-                                // Skip if far from spotlight
-                                float dist = glm::length(basePos - spos);
-                                if (dist > far_plane_spot + 5.0f)
-                                    continue;
-
-                                glm::vec3 srcSize = pr.src_max - pr.src_min;
-                                glm::vec3 srcCenter = (pr.src_min + pr.src_max) * 0.5f;
-                                float footprintDim = std::max(0.001f, std::max(srcSize.x, srcSize.z));
-                                float target = (i < perPropFootprint.size()) ? perPropFootprint[i] : 0.6f;
-                                float scaleUniform = target / footprintDim;
-                                scaleUniform = std::clamp(scaleUniform, 0.02f, 10.0f);
-                                glm::mat4 modelMat{1.0f};
-                                modelMat = glm::translate(modelMat, basePos);
-                                modelMat = glm::scale(modelMat, glm::vec3(scaleUniform));
-                                glm::vec3 centerXZ = glm::vec3(srcCenter.x, 0.0f, srcCenter.z);
-                                modelMat = modelMat * pr.transform * glm::translate(glm::mat4(1.0f), -centerXZ);
-                                glUniformMatrix4fv(spotDepthShader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-                                pr.mesh->render();
-                            }
-                        }
-                    }
-                }
+        if (deferredShading)
+        {
+            deferredTime.begin();
 
-                const float defaultStatueScale = 12.0f;
-                const float cannonScale = 3.0f;
-                const float coffeeScale = 2.0f;
-                const float floorY = -2.0f;
+            // 1. Geometry pass: albedo, normal and depth of the nearest surface
+            gbuffer.resize(main_window->get_buffer_width(), main_window->get_buffer_height());
+            gbuffer.begin();
+            renderSurfaces(gbufferShaders);
 
-                if (!cat_statue.empty())
-                {
-                    renderModelSpotShadow(cat_statue, glm::vec3(0.0f, floorY, 0.0f), spos, far_plane_spot, cullingEnabled, frustum, 8.0f, defaultStatueScale, spotDepthShader);
-                }
-                if (!cannon_statue.empty())
-                {
-                    renderModelSpotShadow(cannon_statue, glm::vec3(20.0f, floorY, 0.0f), spos, far_plane_spot, cullingEnabled, frustum, 5.0f, cannonScale, spotDepthShader);
-                }
-                if (!cart_statue.empty())
-                {
-                    renderModelSpotShadow(cart_statue, glm::vec3(-20.0f, floorY, 0.0f), spos, far_plane_spot, cullingEnabled, frustum, 4.0f, coffeeScale, spotDepthShader);
-                }
-                if (!drill_statue.empty())
-                {
-                    renderModelSpotShadow(drill_statue, glm::vec3(0.0f, floorY, 20.0f), spos, far_plane_spot, cullingEnabled, frustum, 8.0f, defaultStatueScale, spotDepthShader);
-                }
-                if (!horse_statue.empty())
-                {
-                    renderModelSpotShadow(horse_statue, glm::vec3(0.0f, floorY, -20.0f), spos, far_plane_spot, cullingEnabled, frustum, 8.0f, defaultStatueScale, spotDepthShader);
-                }
-                if (!tree_models.empty())
-                {
-                    std::vector<float> treeRotations(tree_positions.size(), 0.0f);
-                    renderModelSpotShadow(tree_models, tree_positions, treeRotations, cullingEnabled, frustum, tree_radius, tree_scale, spotDepthShader);
-                }
+            // 2. Lighting pass into the window. It writes the G-buffer depth
+            // back, so the light bulbs and the skybox still test against it.
+            GLState::bind_framebuffer(0);
+            glViewport(0, 0, main_window->get_buffer_width(), main_window->get_buffer_height());
+            deferredShader->use();
+            glm::mat4 inverseViewProjection = glm::inverse(projection * frame.view);
+            glUniformMatrix4fv(deferredShader->get_uniform_location("inverseViewProjection"_uniform), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+            gbuffer.bind_textures(0);
+            GLState::bind_vertex_array(fullScreenVao);
+            glDepthFunc(GL_ALWAYS);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glDepthFunc(GL_LESS);
+
+            deferredTime.end();
+        }
+        else
+        {
+            forwardTime.begin();
 
-                if (!potted_plant_02.empty())
+            // 1. Depth prepass: the same geometry as the shaded pass, positions only
+            if (depthPrepass)
+            {
+                prepassShader->use();
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                prepassSamples.begin();
+                if (exteriorVisible)
+                    render_exterior_floor_depth(prepassShader);
+                for (size_t i = 0; i < roomTransforms.size() && i < rooms.size(); ++i)
                 {
-                    const float potScale = 4.0f;
-                    std::vector<glm::vec3> outerRoomCenters = {
-                        glm::vec3(20.0f, 0.0f, 0.0f),  // East
-                        glm::vec3(-20.0f, 0.0f, 0.0f), // West
-                        glm::vec3(0.0f, 0.0f, 20.0f),  // South
-                        glm::vec3(0.0f, 0.0f, -20.0f)  // North
-                    };
-                    std::vector<glm::vec3> cornerOffsets = {
-                        glm::vec3(8.0f, 0.0f, 8.0f),
-                        glm::vec3(-8.0f, 0.0f, 8.0f),
-                        glm::vec3(8.0f, 0.0f, -8.0f),
-                        glm::vec3(-8.0f, 0.0f, -8.0f)};
-
-                    for (const auto &center : outerRoomCenters)
-                    {
-                        for (const auto &offset : cornerOffsets)
-                        {
-                            glm::vec3 pos = center + offset;
-                            pos.y = floorY; // Ensure correct floor height
-
-                            // Skip if too far from spotlight
-                            float dist = glm::length(pos - spos);
-                            if (dist > far_plane_spot + 5.0f)
-                                continue;
-
-                            // Check if in spotlight cone
-                            glm::vec3 toObj = glm::normalize(pos - spos);
-                            glm::vec3 spotDir = glm::normalize(sdir);
-                            float angleDeg = glm::degrees(acos(glm::clamp(glm::dot(spotDir, toObj), -1.0f, 1.0f)));
-                            if (angleDeg > (spotOuterDeg * 1.2f))
-                                continue;
-
-                            renderModelSpotShadow(potted_plant_02, pos, spos, far_plane_spot, cullingEnabled, frustum, 2.0f, potScale, spotDepthShader);
-                        }
-                    }
+                    if (roomVisible(i))
+                        rooms[i].render_depth(prepassShader, roomTransforms[i]);
                 }
+                scene.draw(camera_visible, prepassShader, true);
+                prepassSamples.end();
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-                glDisable(GL_CULL_FACE);
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                glViewport(0, 0, main_window->get_buffer_width(), main_window->get_buffer_height());
-
-                // Upload lightSpace matrix
-                Data::shader_list[0]->use();
-                std::string name = "spotLightSpaceMatrices[" + std::to_string(si) + "]";
-                glUniformMatrix4fv(glGetUniformLocation(Data::shader_list[0]->get_program_id(), name.c_str()), 1, GL_FALSE, glm::value_ptr(lightSpace));
+                // Depth is final: shade only the nearest fragment of each pixel
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
             }
-        }
-
-        glClearColor(0.f, 0.f, 0.f, 1.f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 1. Skybox
-        glDepthFunc(GL_LEQUAL);
-        Data::sky_box->render(camera.get_view_matrix(), projection);
-        glDepthFunc(GL_LESS);
-
-        // 2. Piso exterior
-        render_exterior_floor(camera.get_view_matrix(), projection, camera.get_position());
 
-        // 3. Habitaciones y objetos
-        Data::shader_list[0]->use();
+            // 2. Shaded pass
+            shadedSamples.begin();
+            renderSurfaces(forwardShaders);
+            shadedSamples.end();
 
-        // REACTIVAR CONFIGURACIONES ORIGINALES
-        glUniform1i(Data::shader_list[0]->get_uniform_texture_sampler_id(), 0);
-        glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "normal_sampler"), 1);
-        glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "enableShadows"), enableShadows ? 1 : 0);
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
 
-        // RESTAURAR LUCES ORIGINALES
-        glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "dirLight.direction"), -0.2f, -1.0f, -0.3f);
-        glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "dirLight.diffuse"), 0.5f, 0.5f, 0.5f);
-        glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "dirLight.specular"), 0.1f, 0.1f, 0.1f);
-
-        // Shadow maps
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, shadowCubemap.get_depth_cubemap_id());
-        glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "shadowMap"), 3);
-        glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "far_plane"), SHADOW_FAR);
-        glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "shadowRadius"), 0.12f);
+            forwardTime.end();
+        }
 
-        // Matrices
-        glUniformMatrix4fv(Data::shader_list[0]->get_uniform_projection_id(), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(Data::shader_list[0]->get_uniform_view_id(), 1, GL_FALSE, glm::value_ptr(camera.get_view_matrix()));
-        glUniform3fv(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "viewPosition"), 1, glm::value_ptr(camera.get_position()));
+        // Render lightbulbs
+        Data::shader_list[1]->use();
 
-        // Point lights
-        for (size_t i = 0; i < lightbulbs.size(); ++i)
+        for (const auto &bulb : lightbulbs)
         {
-            lightbulbs[i].use_light(Data::shader_list[0], i);
+            bulb.render(Data::shader_list[1]);
         }
 
-        // Spotlights ORIGINALES
-        for (size_t si = 0; si < roomTransforms.size() && si < 5; ++si)
-        {
-            glm::vec3 spos = glm::vec3(roomTransforms[si] * glm::vec4(0.0f, 7.5f, 0.0f, 1.0f));
-            glm::vec3 sdir = glm::vec3(0.0f, -1.0f, 0.0f);
-
-            std::string base = "spotLights[" + std::to_string(si) + "]";
-            glUniform3fv(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".position").c_str()), 1, glm::value_ptr(spos));
-            glUniform3fv(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".direction").c_str()), 1, glm::value_ptr(sdir));
-            glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".cutOff").c_str()), cos(glm::radians(30.0f)));
-            glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".outerCutOff").c_str()), cos(glm::radians(spotOuterDeg)));
-            glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".constant").c_str()), 1.0f);
-            glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".linear").c_str()), 0.09f);
-            glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".quadratic").c_str()), 0.032f);
-            glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".ambient").c_str()), 0.02f, 0.02f, 0.02f);
-            glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".diffuse").c_str()), 3.0f, 3.0f, 2.7f);
-            glUniform3f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), (base + ".specular").c_str()), 1.0f, 1.0f, 1.0f);
-        }
+        // 3. Skybox last, on the far plane: only pixels nothing covered
+        glDepthFunc(GL_LEQUAL);
+        Data::sky_box->render(camera.get_view_matrix(), projection);
+        glDepthFunc(GL_LESS);
+
+        main_window->swap_buffers();
 
-        // Spot shadow maps
-        for (int si = 0; si < (int)spotDepthMaps.size(); ++si)
+        if (benchmark && ++benchmarkStep == benchmarkFramesPerPath)
         {
-            glActiveTexture(GL_TEXTURE4 + si);
-            glBindTexture(GL_TEXTURE_2D, spotDepthMaps[si]);
-            std::string name = "spotShadowMaps[" + std::to_string(si) + "]";
-            glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), name.c_str()), 4 + si);
+            const GpuQuery &timer = *benchmarkPath->timer;
+            const std::size_t measured = benchmarkFramesPerPath - BENCHMARK_WARMUP - 1;
+            const double gpuMs = timer.get_count() ? timer.get_total() / 1.0e6 / timer.get_count() : 0.0;
+            benchmarkResults.push_back(std::string{benchmarkPath->name} + ": " + std::to_string(gpuMs) + " ms GPU (camera passes), " +
+                                       std::to_string(benchmarkFrameTime * 1000.0 / measured) + " ms per frame");
         }
-
-        // Render rooms
-        for (size_t i = 0; i < roomTransforms.size() && i < rooms.size(); ++i)
+        if (benchmark && ++benchmarkFrame == benchmarkFramesPerPath * std::size(benchmarkPaths))
         {
-            glm::vec3 roomCenter = glm::vec3(roomTransforms[i] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
-            float roomRadius = 15.0f;
-            if (!cullingEnabled || frustum.isSphereInFrustum(roomCenter, roomRadius))
-            {
-                rooms[i].render(Data::shader_list[0], roomTransforms[i]);
-            }
+            std::cout << "Benchmark at " << main_window->get_buffer_width() << "x" << main_window->get_buffer_height() << ", "
+                      << benchmarkViews << " views of " << BENCHMARK_FRAMES_PER_VIEW << " frames per path:" << std::endl;
+            for (const auto &result : benchmarkResults)
+                std::cout << "  " << result << std::endl;
+            break;
         }
 
-        if (!imported_models.empty())
+        // F1 prints this frame's statistics
+        const bool statsKeyDown = main_window->get_keys()[GLFW_KEY_F1];
+        if (statsKeyDown && !statsKeyWasDown)
         {
-            Data::shader_list[0]->use();
-            glUniform1i(Data::shader_list[0]->get_uniform_texture_sampler_id(), 0);
-            glUniform1i(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "normal_sampler"), 1);
-            glUniform1f(glGetUniformLocation(Data::shader_list[0]->get_program_id(), "material.shininess"), 32.0f);
-
-            const float modelScale = 2.0f;
-            const float floorY = -2.0f;
-            std::vector<glm::vec3> positions = {
-                glm::vec3(0.0f, floorY, 28.5f), glm::vec3(0.0f, floorY, -28.5f),
-                glm::vec3(28.5f, floorY, 0.0f), glm::vec3(-28.5f, floorY, 0.0f)};
-            std::vector<float> rotations = {
-                0.0f, glm::pi<float>(), glm::radians(-90.0f), glm::radians(90.0f)};
-
-            placeModelInPosition(imported_models, positions, rotations, cullingEnabled, frustum, 5.0f, modelScale, fallback_albedo, fallback_normal);
-
-            float tableHeight = 0.0f;
-            for (auto &r : imported_models)
+            std::cout << "Uniform lookups: " << Shader::get_cached_lookups() << " per frame served from reflection tables, "
+                      << Shader::get_driver_lookups() << " glGetUniformLocation calls" << std::endl;
+            std::cout << "Portals: " << portals.get_visible_cells() << " of " << portals.get_cell_count() << " cells visible, "
+                      << portals.get_portals_tested() << " of " << portals.get_portal_count() << " doorways tested, "
+                      << camera_visible.instances.size() << " instances submitted" << std::endl;
+            std::cout << "Shadow casters: " << shadowCastersDrawn << " instances drawn over all shadow views this frame" << std::endl;
+            for (int layered = 0; layered < 2; ++layered)
             {
-                tableHeight = std::max(tableHeight, r.src_max.y - r.src_min.y);
+                if (pointShadowUpdates[layered] == 0)
+                    continue;
+                std::cout << "Point shadow submission (" << (layered ? "layered" : "six passes") << "): "
+                          << pointShadowSubmitMs[layered] / pointShadowUpdates[layered] << " ms CPU average over "
+                          << pointShadowUpdates[layered] << " updates" << std::endl;
             }
-            tableHeight *= modelScale;
-
-            std::vector<float> perPropFootprintMain = {0.15f, 0.6f, 0.8f, 1.5f};
-            for (size_t i = 0; i < prop_models.size() && i < positions.size(); ++i)
+            for (const auto &light : shadowScheduler.get_stats())
             {
-                auto &group = prop_models[i];
-                glm::vec3 basePos = positions[i];
-                basePos.y = floorY + tableHeight + 0.02f;
-                for (auto &pr : group)
-                {
-                    if (!cullingEnabled || frustum.isSphereInFrustum(basePos, 1.0f))
-                    {
-                        glm::vec3 srcSize = pr.src_max - pr.src_min;
-                        glm::vec3 srcCenter = (pr.src_min + pr.src_max) * 0.5f;
-                        float footprintDim = std::max(0.001f, std::max(srcSize.x, srcSize.z));
-                        float target = (i < perPropFootprintMain.size()) ? perPropFootprintMain[i] : 0.6f;
-                        float scaleUniform = target / footprintDim;
-                        scaleUniform = std::clamp(scaleUniform, 0.02f, 10.0f);
-
-                        glm::mat4 modelMat{1.0f};
-                        modelMat = glm::translate(modelMat, basePos);
-                        modelMat = glm::scale(modelMat, glm::vec3(scaleUniform));
-                        glm::vec3 centerXZ = glm::vec3(srcCenter.x, 0.0f, srcCenter.z);
-                        modelMat = modelMat * pr.transform * glm::translate(glm::mat4(1.0f), -centerXZ);
-
-                        glUniformMatrix4fv(Data::shader_list[0]->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(modelMat));
-
-                        if (pr.albedo)
-                            pr.albedo->use();
-                        else
-                            fallback_albedo->use();
-                        glActiveTexture(GL_TEXTURE1);
-                        if (pr.normal)
-                            glBindTexture(GL_TEXTURE_2D, pr.normal->get_id());
-                        else
-                            glBindTexture(GL_TEXTURE_2D, fallback_normal->get_id());
-
-                        pr.mesh->render();
-                    }
-                }
+                std::cout << "Shadow " << light.name << ": " << light.refreshes << " refreshes, last waited "
+                          << light.last_wait << " frames, worst " << light.worst_wait << std::endl;
             }
-
-            if (!potted_models.empty())
+            std::cout << "Spot shadow tiles:";
+            for (int si = 0; si < SPOT_COUNT; ++si)
+                std::cout << " " << spotAtlas.get_tile(si).size;
+            std::cout << " (atlas " << spotAtlas.get_size() << ")" << std::endl;
+            std::cout << "Shadow faces rendered this frame: " << shadowScheduler.get_scheduled_faces() << " of "
+                      << shadowScheduler.get_face_budget() << std::endl;
+            if (!frameTimes.empty())
             {
-                std::vector<glm::vec3> potPositions = {
-                    glm::vec3(8.0f, floorY, 8.0f), glm::vec3(-8.0f, floorY, 8.0f),
-                    glm::vec3(8.0f, floorY, -8.0f), glm::vec3(-8.0f, floorY, -8.0f)};
-                std::vector<float> potRot = {0.0f, glm::pi<float>(), glm::radians(90.0f), glm::radians(-90.0f)};
-                const float potScale = 4.0f;
-
-                placeModelInPosition(potted_models, potPositions, potRot, cullingEnabled, frustum, 2.0f, potScale, fallback_albedo, fallback_normal);
+                std::vector<float> sorted = frameTimes;
+                std::sort(sorted.begin(), sorted.end());
+                auto percentile = [&](float p) { return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))] * 1000.0f; };
+                std::cout << "Frame time over " << sorted.size() << " frames: p50 " << percentile(0.5f) << " ms, p95 "
+                          << percentile(0.95f) << " ms, p99 " << percentile(0.99f) << " ms, max " << sorted.back() * 1000.0f << " ms" << std::endl;
             }
-
-            if (!picture_models.empty())
+            const std::uint64_t shaded = shadedSamples.get_result();
+            if (deferredShading)
             {
-                const float pictureYOffset = 3.5f;
-                const float pictureShift = 4.0f;
-                const float wallDist = 9.8f;
-                std::vector<glm::vec3> picPositions = {
-                    glm::vec3(pictureShift, floorY + pictureYOffset, wallDist),
-                    glm::vec3(pictureShift, floorY + pictureYOffset, -wallDist),
-                    glm::vec3(wallDist, floorY + pictureYOffset, pictureShift),
-                    glm::vec3(-wallDist, floorY + pictureYOffset, pictureShift)};
-                std::vector<float> picRot = {glm::pi<float>(), 0.0f, glm::radians(270.0f), glm::radians(90.0f)};
-                const float picScale = 4.0f;
-
-                placeModelInPosition(picture_models, picPositions, picRot, cullingEnabled, frustum, 2.0f, picScale, fallback_albedo, fallback_normal);
-
-                if (!picture2_models.empty())
-                {
-                    std::vector<glm::vec3> pic2Positions = {
-                        glm::vec3(-pictureShift, floorY + pictureYOffset, wallDist),
-                        glm::vec3(-pictureShift, floorY + pictureYOffset, -wallDist),
-                        glm::vec3(wallDist, floorY + pictureYOffset, -pictureShift),
-                        glm::vec3(-wallDist, floorY + pictureYOffset, -pictureShift)};
-                    placeModelInPosition(picture2_models, pic2Positions, picRot, cullingEnabled, frustum, 2.0f, picScale, fallback_albedo, fallback_normal);
-                }
+                std::cout << "Depth prepass: not used by the deferred path" << std::endl;
             }
-
-            const float defaultStatueScale = 12.0f;
-            const float cannonScale = 3.0f;
-            const float coffeeScale = 2.0f;
-
-            if (!cat_statue.empty())
+            else if (depthPrepass)
             {
-                placeModelInPosition(cat_statue, glm::vec3(0.0f, floorY, 0.0f), cullingEnabled, frustum, 8.0f, defaultStatueScale, fallback_albedo, fallback_normal);
+                const std::uint64_t unsorted = prepassSamples.get_result();
+                std::cout << "Depth prepass: " << shaded << " fragments shaded, " << unsorted << " without the prepass ("
+                          << (unsorted > shaded ? unsorted - shaded : 0) << " saved)" << std::endl;
             }
-            if (!cannon_statue.empty())
-            {
-                placeModelInPosition(cannon_statue, glm::vec3(20.0f, floorY, 0.0f), cullingEnabled, frustum, 5.0f, cannonScale, fallback_albedo, fallback_normal);
-            }
-            if (!cart_statue.empty())
-            {
-                placeModelInPosition(cart_statue, glm::vec3(-20.0f, floorY, 0.0f), cullingEnabled, frustum, 4.0f, coffeeScale, fallback_albedo, fallback_normal);
-            }
-            if (!drill_statue.empty())
-            {
-                placeModelInPosition(drill_statue, glm::vec3(0.0f, floorY, 20.0f), cullingEnabled, frustum, 8.0f, defaultStatueScale, fallback_albedo, fallback_normal);
-            }
-            if (!horse_statue.empty())
+            else
             {
-                placeModelInPosition(horse_statue, glm::vec3(0.0f, floorY, -20.0f), cullingEnabled, frustum, 8.0f, defaultStatueScale, fallback_albedo, fallback_normal);
+                std::cout << "Depth prepass off: " << shaded << " fragments shaded" << std::endl;
             }
-            if (!tree_models.empty())
+            const GpuQuery &cameraTime = deferredShading ? deferredTime : forwardTime;
+            if (cameraTime.get_count() > 0)
             {
-                for (const auto &position : tree_positions)
-                {
-                    placeModelInPosition(tree_models, position, cullingEnabled, frustum, tree_radius, tree_scale, fallback_albedo, fallback_normal);
-                }
-            }
-
-            if (!potted_plant_02.empty())
-            {
-                const float potScale = 4.0f;
-                std::vector<glm::vec3> outerRoomCenters = {
-                    glm::vec3(20.0f, 0.0f, 0.0f), glm::vec3(-20.0f, 0.0f, 0.0f),
-                    glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(0.0f, 0.0f, -20.0f)};
-                std::vector<glm::vec3> cornerOffsets = {
-                    glm::vec3(8.0f, 0.0f, 8.0f), glm::vec3(-8.0f, 0.0f, 8.0f),
-                    glm::vec3(8.0f, 0.0f, -8.0f), glm::vec3(-8.0f, 0.0f, -8.0f)};
-
-                for (const auto &center : outerRoomCenters)
-                {
-                    for (const auto &offset : cornerOffsets)
-                    {
-                        glm::vec3 pos = center + offset;
-                        pos.y = floorY;
-                        placeModelInPosition(potted_plant_02, pos, cullingEnabled, frustum, 2.0f, potScale, fallback_albedo, fallback_normal);
-                    }
-                }
+                std::cout << (deferredShading ? "Deferred" : "Forward") << " camera passes: " << cameraTime.get_result() / 1.0e6
+                          << " ms GPU last frame, " << cameraTime.get_total() / 1.0e6 / cameraTime.get_count() << " ms average over "
+                          << cameraTime.get_count() << " frames" << std::endl;
             }
+            const LightClusters &clusters = clusteredLighting ? lightClusters : unclusteredLights;
+            std::cout << "Light clusters: " << clusters.get_light_count() << " lights, " << clusters.get_occupied_clusters() << " of "
+                      << clusters.get_cluster_count() << " clusters lit, " << clusters.get_reference_count() << " light references, at most "
+                      << clusters.get_max_cluster_lights() << " per cluster, built in " << clusterBuildMs << " ms CPU" << std::endl;
+            std::cout << "Shader variants: " << ShaderCache::get_live_count() << " compiled, "
+                      << ShaderCache::get_hits() << " requests served from the cache" << std::endl;
+            std::cout << "GL state changes: " << GLState::get_issued() << " issued, "
+                      << GLState::get_skipped() << " skipped as redundant" << std::endl;
         }
-
-        // Render lightbulbs
-        Data::shader_list[1]->use();
-        glUniformMatrix4fv(glGetUniformLocation(Data::shader_list[1]->get_program_id(), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(Data::shader_list[1]->get_program_id(), "view"), 1, GL_FALSE, glm::value_ptr(camera.get_view_matrix()));
-
-        for (const auto &bulb : lightbulbs)
-        {
-            bulb.render(Data::shader_list[1]);
-        }
-
-        glUseProgram(0);
-        main_window->swap_buffers();
+        statsKeyWasDown = statsKeyDown;
+        Shader::reset_lookup_counters();
+        GLState::reset_counters();
     }
 
+    GLState::forget_vertex_array(fullScreenVao);
+    glDeleteVertexArrays(1, &fullScreenVao);
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#version 410
+
+#include "lighting.glsl"
+
+// G-buffer written by gbuffer.frag
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+// Window coordinates and depth back to world space
+uniform mat4 inverseViewProjection;
+
+out vec4 FragColor;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // Nothing was drawn here; the skybox fills it afterwards
+    if (depth == 1.0)
+        discard;
+
+    vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+    vec4 normal = texelFetch(gNormal, pixel, 0);
+
+    vec2 uv = gl_FragCoord.xy / vec2(textureSize(gDepth, 0));
+    vec4 position = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = position.xyz / position.w;
+
+    int flags = int(normal.w + 0.5);
+    vec3 result = ShadeSurface(fragPos, normalize(normal.xyz), albedo.rgb, albedo.a * 256.0, flags & 1, (flags & 2) != 0);
+    FragColor = vec4(result, 1.0);
+
+    // Later passes (light bulbs, skybox) depth test against the scene
+    gl_FragDepth = depth;
+}
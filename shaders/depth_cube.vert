@@ -1,16 +1,19 @@
 #version 410 core
 
 layout(location = 0) in vec3 position;
+layout(location = 4) in mat4 instanceModel;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+uniform bool useInstancing;
 
 out vec3 FragPos;
 
 void main()
 {
-    vec4 worldPos = model * vec4(position, 1.0);
+    mat4 M = useInstancing ? instanceModel : model;
+    vec4 worldPos = M * vec4(position, 1.0);
     FragPos = worldPos.xyz;
     gl_Position = projection * view * worldPos;
 }
@@ -0,0 +1,15 @@
+#version 410 core
+
+// World-space pass-through; depth_cube.geom projects each triangle into the
+// cubemap faces
+layout(location = 0) in vec3 position;
+layout(location = 4) in mat4 instanceModel;
+
+uniform mat4 model;
+uniform bool useInstancing;
+
+void main()
+{
+    mat4 M = useInstancing ? instanceModel : model;
+    gl_Position = M * vec4(position, 1.0);
+}
@@ -0,0 +1,24 @@
+#version 410
+
+// Position-only version of shader.vert for the camera's depth prepass: same
+// inputs and the same expression, so the depths match bit for bit
+layout (location = 0) in vec3 aPos;
+layout (location = 4) in mat4 aInstanceModel;
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition; // xyz
+};
+
+uniform mat4 model;
+uniform bool useInstancing;
+
+invariant gl_Position;
+
+void main()
+{
+    mat4 M = useInstancing ? aInstanceModel : model;
+    gl_Position = projection * view * M * vec4(aPos, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 410
+
+#include "surface.glsl"
+
+// G-buffer layout (see GBuffer.hpp). Lighting happens later, once per pixel,
+// in deferred_lighting.frag.
+layout (location = 0) out vec4 gAlbedo; // rgb, a: shininess / 256
+layout (location = 1) out vec4 gNormal; // world-space normal, w: flags
+
+void main()
+{
+    gAlbedo = vec4(texture(texture_sampler, TexCoord).rgb, material.shininess / 256.0);
+    // The per-draw lighting inputs travel with the normal: the directional
+    // light in bit 0, POINT_SHADOWS in bit 1
+    gNormal = vec4(SurfaceNormal(), float(dirLightIndex + (POINT_SHADOWS != 0 ? 2 : 0)));
+}
@@ -2,9 +2,15 @@
 
 layout (location = 0) in vec3 aPos;
 
+// Per-frame camera data, shared by every program (FrameBlock in UniformBlocks.hpp)
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition; // xyz
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
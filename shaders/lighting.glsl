@@ -0,0 +1,314 @@
+// Lighting shared by the forward shader (shader.frag) and the deferred
+// lighting pass (deferred_lighting.frag): the light blocks and samplers, and
+// ShadeSurface(), which lights one surface point with every light reaching it.
+//
+// Specialized at compile time by Shader defines (see surface_defines() in
+// main.cpp); the defaults below are the full-featured variant:
+//   POINT_SHADOWS      0 drops the point light shadow cubemap
+//   SPOT_SHADOWS       0 drops the spot shadow atlas
+//   POINT_PCF_SAMPLES  cubemap taps per fragment, 1 to 12
+//   SPOT_PCF_SAMPLES   atlas taps per fragment, 1 or 4
+//   NR_DIR_LIGHTS, NR_SPOT_SHADOWS: array sizes of the Lights and Shadows
+//   blocks, passed from LightsBlock and ShadowsBlock
+#ifndef POINT_SHADOWS
+#define POINT_SHADOWS 1
+#endif
+#ifndef SPOT_SHADOWS
+#define SPOT_SHADOWS 1
+#endif
+#ifndef POINT_PCF_SAMPLES
+#define POINT_PCF_SAMPLES 12
+#endif
+#ifndef SPOT_PCF_SAMPLES
+#define SPOT_PCF_SAMPLES 4
+#endif
+#ifndef NR_DIR_LIGHTS
+#define NR_DIR_LIGHTS 2
+#endif
+#ifndef NR_SPOT_SHADOWS
+#define NR_SPOT_SHADOWS 5
+#endif
+
+// Per-frame camera data (FrameBlock in UniformBlocks.hpp)
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition; // xyz
+};
+
+// Light structs use vec4 members only, so their std140 layout matches the
+// CPU structs in UniformBlocks.hpp one to one
+struct DirLight {
+    vec4 direction;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+// Point and spot lights, seven texels each (SpotLightData, written by
+// LightClusters). A point light has no cone.
+struct Light {
+    vec4 position;    // xyz, w: range past which the light is ignored
+    vec4 direction;   // xyz, w: shadow map (see CalcLight), -1 for none
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation; // constant, linear, quadratic, w: 1 for a spot
+    vec4 cone;        // cosines of the inner and outer cone angles
+};
+
+layout (std140) uniform Lights
+{
+    ivec4 clusterGrid;    // tiles across, tiles down, depth slices, light count
+    vec4 clusterMapping;  // tiles per pixel (xy), log(depth) to slice scale and bias (zw)
+    DirLight dirLights[NR_DIR_LIGHTS];
+};
+
+// Clustered light lists: every light, then per cluster an offset and count
+// into the index list
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterLights;
+uniform usamplerBuffer lightIndices;
+
+layout (std140) uniform Shadows
+{
+    mat4 spotLightSpaceMatrices[NR_SPOT_SHADOWS];
+    vec4 spotShadowTiles[NR_SPOT_SHADOWS]; // atlas uv offset (xy) and scale (zw)
+    float far_plane;
+    float shadowRadius; // world-space sampling radius for PCF
+};
+
+#if SPOT_SHADOWS
+// Spot shadowing: every spot map is a tile of one atlas
+uniform sampler2D spotShadowAtlas;
+#endif
+
+#if POINT_SHADOWS
+// Shadow cubemap for the (single) point light
+uniform samplerCube shadowMap;
+#endif
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float shininess);
+Light FetchLight(int index);
+vec3 CalcLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float shininess, bool pointShadow);
+#if POINT_SHADOWS
+float CalcPointShadow(vec3 lightPos, vec3 normal, vec3 fragPos);
+#endif
+#if SPOT_SHADOWS
+float CalcSpotShadow(int index, vec3 fragPos, vec3 normal, vec3 lightDir);
+#endif
+
+// Color of the surface at `fragPos` (world space) with normal `norm`, lit by
+// directional light `dirLight` and the point and spot lights of the cluster
+// holding the fragment being shaded. `pointShadow` cleared ignores the point
+// light shadow.
+vec3 ShadeSurface(vec3 fragPos, vec3 norm, vec3 albedo, float shininess, int dirLight, bool pointShadow)
+{
+    vec3 viewDir = normalize(viewPosition.xyz - fragPos);
+
+    // Phase 1: Directional lighting
+    vec3 result = CalcDirLight(dirLights[dirLight], norm, viewDir, albedo, shininess);
+
+    // Phase 2: Point and spot lights of this fragment's cluster
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    ivec3 cell = ivec3(vec3(gl_FragCoord.xy * clusterMapping.xy, log(max(depth, 1e-4)) * clusterMapping.z + clusterMapping.w));
+    cell = clamp(cell, ivec3(0), clusterGrid.xyz - 1);
+    int cluster = (cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x;
+    uvec2 list = texelFetch(clusterLights, cluster).rg; // offset, count
+    for (uint i = 0u; i < list.y; ++i)
+    {
+        int index = int(texelFetch(lightIndices, int(list.x + i)).r);
+        result += CalcLight(FetchLight(index), norm, fragPos, viewDir, albedo, shininess, pointShadow);
+    }
+
+    // Global ambient light
+    vec3 ambient = vec3(0.1) * albedo;
+    result += ambient;
+
+    return result;
+}
+
+// calculates the color when using a directional light.
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float shininess)
+{
+    vec3 lightDir = normalize(-light.direction.xyz);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    // combine results
+    vec3 diffuse  = light.diffuse.rgb  * diff * albedo;
+    vec3 specular = light.specular.rgb * spec * vec3(1.0); // White highlight
+    return (diffuse + specular);
+}
+
+Light FetchLight(int index)
+{
+    int base = index * 7;
+    Light light;
+    light.position = texelFetch(lightData, base);
+    light.direction = texelFetch(lightData, base + 1);
+    light.ambient = texelFetch(lightData, base + 2);
+    light.diffuse = texelFetch(lightData, base + 3);
+    light.specular = texelFetch(lightData, base + 4);
+    light.attenuation = texelFetch(lightData, base + 5);
+    light.cone = texelFetch(lightData, base + 6);
+    return light;
+}
+
+// calculates the color of a point or spot light. Outside its range or cone
+// a light adds nothing, and its shadow map is not read.
+vec3 CalcLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float shininess, bool pointShadow)
+{
+    vec3 toLight = light.position.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance > light.position.w)
+        return vec3(0.0);
+    vec3 lightDir = toLight / distance;
+
+    // Spotlight intensity based on angle between light direction and the
+    // vector from light to fragment
+    bool spot = light.attenuation.w > 0.5;
+    float intensity = 1.0;
+    if (spot)
+    {
+        float theta = dot(-lightDir, normalize(light.direction.xyz));
+        if (theta <= light.cone.y)
+            return vec3(0.0);
+        float epsilon = light.cone.x - light.cone.y;
+        intensity = clamp((theta - light.cone.y) / max(epsilon, 1e-6), 0.0, 1.0);
+    }
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float attenuation = intensity / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+
+    vec3 ambient = light.ambient.rgb * albedo * attenuation;
+    vec3 diffuse = light.diffuse.rgb * diff * albedo * attenuation;
+    vec3 specular = light.specular.rgb * spec * vec3(1.0) * attenuation;
+
+    int shadowIndex = int(light.direction.w);
+    if (shadowIndex < 0)
+        return ambient + diffuse + specular;
+
+    if (spot)
+    {
+#if SPOT_SHADOWS
+        // Spot shadows (one atlas tile per Shadows slot) darken the whole
+        // contribution
+        float sshadow = CalcSpotShadow(shadowIndex, fragPos, normal, lightDir);
+        return (1.0 - sshadow) * (ambient + diffuse + specular);
+#else
+        return ambient + diffuse + specular;
+#endif
+    }
+
+#if POINT_SHADOWS
+    // Shadow calculation for point light (cubemap)
+    // Only apply shadows when the surface is actually facing the light.
+    // This prevents a shadow that was cast onto one side of a thin wall
+    // from darkening the opposite face.
+    if (diff > 0.0 && pointShadow) {
+        float shadow = CalcPointShadow(light.position.xyz, normal, fragPos);
+        // Reduce diffuse and specular when in shadow
+        diffuse *= (1.0 - shadow);
+        specular *= (1.0 - shadow);
+    }
+#endif
+    return (ambient + diffuse + specular);
+}
+
+#if POINT_SHADOWS
+float CalcPointShadow(vec3 lightPos, vec3 normal, vec3 fragPos)
+{
+    vec3 fragToLight = fragPos - lightPos;
+    float currentDepth = length(fragToLight);
+    // Bias to avoid shadow acne (slope-scale + constant bias)
+    // Increase slope-scale slightly and clamp so we avoid small acne but don't detach shadows.
+    float normalDot = dot(normal, normalize(lightPos - fragPos));
+    float bias_const = 0.005; // base constant bias
+    float slopeScale = 0.08;  // slope-scale multiplier (was effectively ~0.02 before)
+    float bias = max(slopeScale * (1.0 - normalDot), bias_const);
+    bias = clamp(bias, 0.001, 0.2);
+
+    // Poisson-disk-like PCF with per-fragment rotation to reduce banding/ghosting.
+    // Smaller kernels take the first POINT_PCF_SAMPLES points.
+    const int SAMPLE_COUNT = POINT_PCF_SAMPLES;
+    const vec3 poissonDisk[12] = vec3[](
+        vec3( 0.5381,  0.1856,  0.1234), vec3( 0.1379,  0.2486, -0.1444), vec3( 0.3371, -0.5679,  0.3456),
+        vec3(-0.7255,  0.2451,  0.5678), vec3(-0.1839, -0.3887, -0.2444), vec3( 0.1234,  0.4567, -0.3333),
+        vec3( 0.6543, -0.2311,  0.1111), vec3(-0.4444,  0.3333, -0.2222), vec3( 0.2222, -0.1111,  0.4444),
+        vec3(-0.1111,  0.7777, -0.3333), vec3( 0.8888, -0.4444,  0.2222), vec3(-0.6666, -0.2222,  0.5555)
+    );
+
+    float occluded = 0.0;
+    float radius = shadowRadius * (currentDepth / far_plane);
+
+    // rotation angle per-fragment (based on FragPos hash)
+    float rnd = fract(sin(dot(fragPos.xyz , vec3(12.9898,78.233,45.164))) * 43758.5453);
+    float angle = rnd * 6.28318530718; // 2*pi
+    vec3 axis = normalize(fragToLight);
+
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        // rotate sample vector around the fragToLight axis using Rodrigues' rotation formula
+        vec3 v = poissonDisk[i];
+        vec3 v_rot = v * cos(angle) + cross(axis, v) * sin(angle) + axis * dot(axis, v) * (1.0 - cos(angle));
+        vec3 dir = normalize(fragToLight + v_rot * radius);
+    float sampleDepth = texture(shadowMap, dir).r * far_plane;
+    // Add a tiny epsilon to sampled depth to further reduce precision-induced acne
+    if (currentDepth - bias > sampleDepth + 0.0005) occluded += 1.0;
+    }
+
+    float shadow = occluded / float(SAMPLE_COUNT);
+    return shadow;
+}
+#endif
+
+#if SPOT_SHADOWS
+float CalcSpotShadow(int index, vec3 fragPos, vec3 normal, vec3 lightDir)
+{
+    // Transform fragment into light clip space
+    vec4 fragPosLS = spotLightSpaceMatrices[index] * vec4(fragPos, 1.0);
+    vec3 projCoords = fragPosLS.xyz / fragPosLS.w;
+    // Transform to [0,1]
+    projCoords = projCoords * 0.5 + 0.5;
+
+    // If outside the light's frustum, no shadow
+    if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0 || projCoords.z < 0.0 || projCoords.z > 1.0)
+        return 0.0;
+
+    float currentDepth = projCoords.z;
+
+    // PCF sampling
+    float shadow = 0.0;
+    // Adaptive bias based on surface angle
+    float bias = max(0.0005 * (1.0 - dot(normal, lightDir)), 0.00005);
+    // One texel of this light's tile, whatever its resolution. Samples are
+    // clamped to the tile so the filter never reads a neighbouring map.
+    vec4 tile = spotShadowTiles[index];
+    vec2 texelSize = 1.0 / vec2(textureSize(spotShadowAtlas, 0));
+    vec2 tileMin = tile.xy + 0.5 * texelSize;
+    vec2 tileMax = tile.xy + tile.zw - 0.5 * texelSize;
+    vec2 tileUV = tile.xy + projCoords.xy * tile.zw;
+#if SPOT_PCF_SAMPLES >= 4
+    for (int x = -1; x <= 1; x += 2)
+    {
+        for (int y = -1; y <= 1; y += 2)
+        {
+            vec2 offset = vec2(float(x), float(y)) * texelSize;
+            float closestDepth = texture(spotShadowAtlas, clamp(tileUV + offset, tileMin, tileMax)).r;
+            if (currentDepth - bias > closestDepth)
+                shadow += 1.0;
+        }
+    }
+    shadow /= float(4);
+#else
+    float closestDepth = texture(spotShadowAtlas, clamp(tileUV, tileMin, tileMax)).r;
+    if (currentDepth - bias > closestDepth)
+        shadow = 1.0;
+#endif
+    return shadow;
+}
+#endif
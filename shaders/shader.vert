@@ -1,29 +1,50 @@
 #version 410
 
+// Packed meshes feed normal/tangent as normalized 10_10_10_2 and the uv as
+// half floats; the fetch expands them, and the normalize() calls below undo
+// the quantization error.
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
 layout (location = 3) in vec3 aTangent;
+// Per-instance model matrix (columns at 4-7) and normal matrix (8-10), used
+// when useInstancing is set
+layout (location = 4) in mat4 aInstanceModel;
+layout (location = 8) in mat3 aInstanceNormalMatrix;
 
 out vec2 TexCoord;
 out vec3 FragPos;
 out mat3 TBN;
 out vec3 GeomNormal;
 
+// The depth prepass (depth_prepass.vert) computes the same position; both
+// are invariant so the main pass can test depth with GL_EQUAL
+invariant gl_Position;
+
+// Per-frame camera data, shared by every program (FrameBlock in UniformBlocks.hpp)
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPosition; // xyz
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Set with model by Shader::set_model; computed on the CPU (see Transform.hpp)
+uniform mat3 normalMatrix;
+uniform bool useInstancing;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    mat4 M = useInstancing ? aInstanceModel : model;
+    gl_Position = projection * view * M * vec4(aPos, 1.0);
     TexCoord = aTexCoord;
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(M * vec4(aPos, 1.0));
 
     // Create TBN matrix for normal mapping
-    mat3 normalMatrix = mat3(transpose(inverse(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 N = normalize(normalMatrix * aNormal);
+    mat3 NM = useInstancing ? aInstanceNormalMatrix : normalMatrix;
+    vec3 T = normalize(NM * aTangent);
+    vec3 N = normalize(NM * aNormal);
     T = normalize(T - dot(T, N) * N); // Gram-Schmidt process to re-orthogonalize
     vec3 B = cross(N, T);
     TBN = mat3(T, B, N);
@@ -10,5 +10,6 @@ uniform mat4 projection;
 void main()
 {
     texture_coordinates = pos;
-    gl_Position = projection * view * vec4(pos, 1.0);
+    // z = w puts the sky on the far plane, behind everything drawn before it
+    gl_Position = (projection * view * vec4(pos, 1.0)).xyww;
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+// Surface inputs shared by the forward shader (shader.frag) and the G-buffer
+// pass (gbuffer.frag), both fed by shader.vert.
+//
+// Defines (see lighting.glsl for the others):
+//   NORMAL_MAP     0 for materials without one: the geometric normal is used
+//   POINT_SHADOWS  0 for draws that ignore the point light shadow
+#ifndef NORMAL_MAP
+#define NORMAL_MAP 1
+#endif
+#ifndef POINT_SHADOWS
+#define POINT_SHADOWS 1
+#endif
+
+in vec2 TexCoord;
+in vec3 FragPos;
+in mat3 TBN;
+in vec3 GeomNormal;
+
+uniform sampler2D texture_sampler;
+#if NORMAL_MAP
+uniform sampler2D normal_sampler;
+#endif
+
+// A simple material structure
+struct Material {
+    float shininess;
+};
+uniform Material material;
+
+// Which directional light lights this draw (interior or exterior sun)
+uniform int dirLightIndex;
+
+// World-space normal at this fragment, from the normal map
+vec3 SurfaceNormal()
+{
+#if !NORMAL_MAP
+    return normalize(GeomNormal);
+#else
+    // Obtain normal from normal map. It's in tangent space, so transform to world space.
+    // The range [0,1] is mapped to [-1,1].
+    vec3 norm = texture(normal_sampler, TexCoord).rgb;
+    norm = normalize(norm * 2.0 - 1.0);
+    // transform sampled normal from tangent to world space
+    norm = normalize(TBN * norm);
+    // Ensure normal-map normal lies in same hemisphere as geometric normal
+    // to avoid inverted lighting on the opposite side.
+    if (dot(GeomNormal, norm) < 0.0)
+        norm = -norm;
+    return norm;
+#endif
+}
@@ -6,6 +6,9 @@
 
 #include <Mesh.hpp>
 #include <Texture.hpp>
+#include <TextureCache.hpp>
+#include <MeshCache.hpp>
+#include <ThreadPool.hpp>
 #include <BSlogger.hpp>
 
 #include <glm/glm.hpp>
@@ -28,8 +31,26 @@ namespace AssimpLoader
         return to;
     }
 
-    void processNode(aiNode* node, const aiScene* scene, glm::mat4 parentTransform, 
-                     std::vector<AssimpLoader::Renderable>& out, const std::filesystem::path& model_dir)
+    // Resolve a material texture slot to a file next to the model. Returns an
+    // empty path for embedded ("*0") or missing textures.
+    std::filesystem::path resolveTexture(const aiString& texPath, const std::filesystem::path& model_dir, const char* kind)
+    {
+        std::string tex_rel = texPath.C_Str();
+        if (tex_rel.empty() || tex_rel[0] == '*')
+            return {};
+
+        std::filesystem::path full = model_dir / tex_rel;
+        if (!std::filesystem::exists(full)) {
+            LOG_INIT_COUT();
+            log(LOG_WARN) << "AssimpLoader: " << kind << " not found: " << full << "\n";
+            return {};
+        }
+        return full;
+    }
+
+    void processNode(aiNode* node, const aiScene* scene, glm::mat4 parentTransform,
+                     std::vector<AssimpLoader::MeshData>& out, const std::filesystem::path& model_dir,
+                     Mesh::VertexFormat format)
     {
         glm::mat4 nodeTransform = aiMatrix4x4ToGlm(node->mTransformation);
         glm::mat4 globalTransform = parentTransform * nodeTransform;
@@ -37,7 +58,7 @@ namespace AssimpLoader
         for (unsigned int i = 0; i < node->mNumMeshes; ++i)
         {
             aiMesh* aMesh = scene->mMeshes[node->mMeshes[i]];
-            
+
             // Process Mesh
             std::vector<float> vertices;
             vertices.reserve(aMesh->mNumVertices * 8);
@@ -78,101 +99,76 @@ namespace AssimpLoader
                 }
             }
 
-            std::vector<unsigned int> indices;
-            indices.reserve(aMesh->mNumFaces * 3);
+            AssimpLoader::MeshData data;
+
+            data.indices.reserve(aMesh->mNumFaces * 3);
             for (unsigned int f = 0; f < aMesh->mNumFaces; ++f) {
                 const aiFace& face = aMesh->mFaces[f];
                 if (face.mNumIndices == 3) {
-                    indices.push_back(face.mIndices[0]);
-                    indices.push_back(face.mIndices[1]);
-                    indices.push_back(face.mIndices[2]);
+                    data.indices.push_back(face.mIndices[0]);
+                    data.indices.push_back(face.mIndices[1]);
+                    data.indices.push_back(face.mIndices[2]);
                 }
             }
 
-            auto mesh = Mesh::create(vertices, indices);
+            // Tangent generation is the expensive part of Mesh::create, so it
+            // runs here on the worker instead of on the GL thread.
+            data.vertices = Mesh::build_vertices(vertices, data.indices);
 
-            // Textures
-            std::shared_ptr<Texture> albedo_tex = nullptr;
-            std::shared_ptr<Texture> normal_tex = nullptr;
+            if (format == Mesh::VertexFormat::PACKED && Mesh::can_pack(data.vertices.data(), data.vertices.size() / 11)) {
+                data.format = Mesh::VertexFormat::PACKED;
+                data.packed_vertices = Mesh::pack_vertices(data.vertices.data(), data.vertices.size() / 11);
+                data.vertices = {};
+            }
 
+            // Textures
             if (scene->mMaterials) {
                 aiMaterial* material = scene->mMaterials[aMesh->mMaterialIndex];
                 aiString texPath;
                 if (material->GetTexture(aiTextureType_DIFFUSE, 0, &texPath) == AI_SUCCESS) {
-                     std::string tex_rel = texPath.C_Str();
-                     if (!tex_rel.empty() && tex_rel[0] != '*') {
-                         std::filesystem::path full = model_dir / tex_rel;
-                         if (std::filesystem::exists(full)) {
-                             albedo_tex = std::make_shared<Texture>(full);
-                             albedo_tex->load();
-                         } else {
-                             LOG_INIT_COUT();
-                             log(LOG_WARN) << "AssimpLoader: albedo not found: " << full << "\n";
-                         }
-                     }
+                    data.albedo_path = resolveTexture(texPath, model_dir, "albedo");
                 }
                 if (material->GetTexture(aiTextureType_NORMALS, 0, &texPath) == AI_SUCCESS ||
                     material->GetTexture(aiTextureType_HEIGHT, 0, &texPath) == AI_SUCCESS) {
-                     std::string tex_rel = texPath.C_Str();
-                     if (!tex_rel.empty() && tex_rel[0] != '*') {
-                         std::filesystem::path full = model_dir / tex_rel;
-                         if (std::filesystem::exists(full)) {
-                             normal_tex = std::make_shared<Texture>(full);
-                             normal_tex->load();
-                         } else {
-                             LOG_INIT_COUT();
-                             log(LOG_WARN) << "AssimpLoader: normal not found: " << full << "\n";
-                         }
-                     }
+                    data.normal_path = resolveTexture(texPath, model_dir, "normal");
                 }
             }
 
-            if (!albedo_tex) {
-                albedo_tex = std::make_shared<Texture>(255,255,255,255);
-                albedo_tex->load();
-            }
-            if (!normal_tex) {
-                normal_tex = std::make_shared<Texture>(128,128,255,255);
-                normal_tex->load();
-            }
+            data.transform = globalTransform; // Use the accumulated transform
+            data.src_min = minV;
+            data.src_max = maxV;
 
-            AssimpLoader::Renderable r;
-            r.mesh = mesh;
-            r.albedo = albedo_tex;
-            r.normal = normal_tex;
-            r.transform = globalTransform; // Use the accumulated transform
-            r.src_min = minV;
-            r.src_max = maxV;
-            
-            out.push_back(r);
+            out.push_back(std::move(data));
         }
 
         for (unsigned int i = 0; i < node->mNumChildren; ++i)
         {
-            processNode(node->mChildren[i], scene, globalTransform, out, model_dir);
+            processNode(node->mChildren[i], scene, globalTransform, out, model_dir, format);
         }
     }
 
-    std::vector<AssimpLoader::Renderable> loadModel(const std::filesystem::path& path) noexcept
+    ModelData parseModel(const std::filesystem::path& path, Mesh::VertexFormat format) noexcept
     {
-        std::vector<AssimpLoader::Renderable> out;
+        ModelData model;
+        model.path = path;
+
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path.string(),
             aiProcess_Triangulate |
             aiProcess_GenSmoothNormals |
             aiProcess_JoinIdenticalVertices);
 
-        if (!scene || !scene->mRootNode) return out;
+        if (!scene || !scene->mRootNode) return model;
 
         std::filesystem::path model_dir = path.parent_path();
-        
-        processNode(scene->mRootNode, scene, glm::mat4(1.0f), out, model_dir);
+
+        processNode(scene->mRootNode, scene, glm::mat4(1.0f), model.meshes, model_dir, format);
 
         // Post-process: Ground the entire model
-        if (!out.empty()) {
+        if (!model.meshes.empty()) {
             float globalMinY = std::numeric_limits<float>::infinity();
-            
-            for (const auto& r : out) {
+
+            for (const auto& r : model.meshes) {
                 // Transform the 8 corners of the AABB
                 glm::vec3 corners[8] = {
                     {r.src_min.x, r.src_min.y, r.src_min.z},
@@ -194,12 +190,96 @@ namespace AssimpLoader
             // Apply offset
             glm::vec3 offset(0.0f, -globalMinY, 0.0f);
             glm::mat4 offsetMat = glm::translate(glm::mat4(1.0f), offset);
-            
-            for (auto& r : out) {
+
+            for (auto& r : model.meshes) {
                 r.transform = offsetMat * r.transform;
             }
         }
 
+        return model;
+    }
+
+    ModelData importModel(const std::filesystem::path& path) noexcept
+    {
+        ModelData model;
+        if (!MeshCache::read(path, model)) {
+            model = parseModel(path);
+            MeshCache::write(path, model);
+        }
+
+        // Decode every referenced image once; several meshes of a model
+        // usually share the same maps.
+        for (const auto& m : model.meshes) {
+            for (const auto* tex : {&m.albedo_path, &m.normal_path}) {
+                if (!tex->empty() && model.images.find(tex->string()) == model.images.end()) {
+                    model.images.emplace(tex->string(), Texture::decode(*tex));
+                }
+            }
+        }
+
+        return model;
+    }
+
+    std::vector<Renderable> uploadModel(const ModelData& model) noexcept
+    {
+        std::vector<Renderable> out;
+        out.reserve(model.meshes.size());
+
+        auto cachedTexture = [&](const std::filesystem::path& tex) -> std::shared_ptr<Texture> {
+            if (tex.empty())
+                return nullptr;
+            auto image = model.images.find(tex.string());
+            if (image == model.images.end())
+                return TextureCache::get(tex);
+            return TextureCache::get(tex, image->second);
+        };
+
+        std::size_t float_bytes = 0;
+        std::size_t uploaded_bytes = 0;
+
+        for (const auto& m : model.meshes) {
+            AssimpLoader::Renderable r;
+            r.mesh = Mesh::upload(m.format, m.vertex_data(), m.vertex_count(), m.index_data(), m.index_count());
+            float_bytes += m.vertex_count() * Mesh::get_vertex_size(Mesh::VertexFormat::FLOAT);
+            uploaded_bytes += r.mesh->get_vertex_bytes();
+            r.albedo = cachedTexture(m.albedo_path);
+            r.normal = cachedTexture(m.normal_path);
+            r.has_normal_map = r.normal != nullptr;
+
+            if (!r.albedo) {
+                r.albedo = TextureCache::get_solid(255,255,255,255);
+            }
+            if (!r.normal) {
+                r.normal = TextureCache::get_solid(128,128,255,255);
+            }
+
+            r.transform = m.transform;
+            r.src_min = m.src_min;
+            r.src_max = m.src_max;
+
+            out.push_back(r);
+        }
+
+        if (!model.meshes.empty()) {
+            LOG_INIT_COUT();
+            log(LOG_INFO) << "AssimpLoader: " << model.path.lexically_relative(model.path.parent_path().parent_path()).string() << " vertex buffers "
+                          << uploaded_bytes / 1024 << " KiB (" << (float_bytes - uploaded_bytes) / 1024
+                          << " KiB saved by packing)\n";
+        }
+
         return out;
     }
+
+    std::future<ModelData> loadModelAsync(const std::filesystem::path& path) noexcept
+    {
+        // One pool shared by every async load. Assimp::Importer and stb_image
+        // are used with per-call state only, so imports run fully in parallel.
+        static ThreadPool pool;
+        return pool.submit([path]() { return importModel(path); });
+    }
+
+    std::vector<AssimpLoader::Renderable> loadModel(const std::filesystem::path& path) noexcept
+    {
+        return uploadModel(importModel(path));
+    }
 }
@@ -0,0 +1,39 @@
+#include <Bounds.hpp>
+
+#include <algorithm>
+#include <limits>
+
+Bounds Bounds::transformed(const glm::vec3& local_min, const glm::vec3& local_max, const glm::mat4& transform) noexcept
+{
+    glm::vec3 corners[8];
+    Bounds bounds;
+    bounds.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (int i = 0; i < 8; ++i)
+    {
+        const glm::vec3 local{i & 1 ? local_max.x : local_min.x, i & 2 ? local_max.y : local_min.y, i & 4 ? local_max.z : local_min.z};
+        corners[i] = glm::vec3(transform * glm::vec4(local, 1.0f));
+        bounds.min = glm::min(bounds.min, corners[i]);
+        bounds.max = glm::max(bounds.max, corners[i]);
+    }
+
+    bounds.center = (bounds.min + bounds.max) * 0.5f;
+    for (const glm::vec3& corner : corners)
+        bounds.radius = std::max(bounds.radius, glm::length(corner - bounds.center));
+    return bounds;
+}
+
+void Bounds::merge(const Bounds& other) noexcept
+{
+    const glm::vec3 old_center = center;
+    const float old_radius = radius;
+
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+    center = (min + max) * 0.5f;
+
+    // Both spheres seen from the new center, or the new box's half
+    // diagonal, whichever is smaller; each encloses everything
+    const float spheres = std::max(glm::length(old_center - center) + old_radius, glm::length(other.center - center) + other.radius);
+    radius = std::min(spheres, glm::length(max - min) * 0.5f);
+}
@@ -0,0 +1,91 @@
+#include <Bvh.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // The query stack holds one pending sibling per level
+    constexpr unsigned MAX_DEPTH = 60;
+
+    float surface_area(const glm::vec3& min, const glm::vec3& max) noexcept
+    {
+        const glm::vec3 extent = max - min;
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+}
+
+void Bvh::build(std::vector<Item> _items) noexcept
+{
+    items = std::move(_items);
+    nodes.clear();
+    area = 0.0f;
+    if (!items.empty())
+    {
+        nodes.reserve(2 * (items.size() / LEAF_SIZE + 1));
+        build_node(0, static_cast<std::uint32_t>(items.size()), 0);
+        refit_nodes();
+    }
+    built_area = area;
+}
+
+std::uint32_t Bvh::build_node(std::uint32_t first, std::uint32_t count, unsigned depth) noexcept
+{
+    const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    if (count <= LEAF_SIZE || depth >= MAX_DEPTH)
+    {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        return index;
+    }
+
+    // Split at the median center along the axis where centers spread most
+    glm::vec3 lo(std::numeric_limits<float>::max());
+    glm::vec3 hi(std::numeric_limits<float>::lowest());
+    for (std::uint32_t i = first; i < first + count; ++i)
+    {
+        lo = glm::min(lo, items[i].bounds.center);
+        hi = glm::max(hi, items[i].bounds.center);
+    }
+    const glm::vec3 spread = hi - lo;
+    const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : (spread.y >= spread.z ? 1 : 2);
+
+    const std::uint32_t half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+                     [axis](const Item& a, const Item& b) { return a.bounds.center[axis] < b.bounds.center[axis]; });
+
+    build_node(first, half, depth + 1);
+    const std::uint32_t right = build_node(first + half, count - half, depth + 1);
+    nodes[index].first = right;
+    nodes[index].count = 0;
+    return index;
+}
+
+void Bvh::refit_nodes() noexcept
+{
+    // Children always come after their parent
+    area = 0.0f;
+    for (std::size_t i = nodes.size(); i-- > 0;)
+    {
+        fit(nodes[i]);
+        area += surface_area(nodes[i].bounds.min, nodes[i].bounds.max);
+    }
+}
+
+void Bvh::fit(Node& node) noexcept
+{
+    if (node.count > 0)
+    {
+        node.bounds = items[node.first].bounds;
+        for (std::uint32_t i = node.first + 1; i < node.first + node.count; ++i)
+            node.bounds.merge(items[i].bounds);
+    }
+    else
+    {
+        // Left child follows its parent
+        node.bounds = (&node + 1)->bounds;
+        node.bounds.merge(nodes[node.first].bounds);
+    }
+}
@@ -45,6 +45,15 @@ void Camera::update(GLfloat dt) noexcept
     velocity = glm::vec3{0.f, 0.f, 0.f};
 }
 
+void Camera::set_pose(const glm::vec3& _position, GLfloat _pitch, GLfloat _yaw) noexcept
+{
+    position = _position;
+    pitch = _pitch;
+    yaw = _yaw;
+    velocity = glm::vec3{0.f, 0.f, 0.f};
+    update_vectors();
+}
+
 void Camera::update_vectors() noexcept
 {
     front.x = glm::cos(glm::radians(pitch)) * glm::cos(glm::radians(yaw));
@@ -1,5 +1,94 @@
 #include <Frustum.hpp>
 
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+  constexpr std::size_t LANES = 4;
+
+  // Shared driver of the batched tests. outside(plane, base) returns the
+  // 4-bit mask of lanes base..base+3 lying entirely behind `plane`; a group
+  // stops being tested as soon as every lane is rejected.
+  template <typename Outside>
+  void cullGroups(std::size_t count, Outside &&outside, std::vector<std::uint32_t> &visible, std::vector<std::uint8_t> *hints)
+  {
+    visible.clear();
+    const std::size_t groups = (count + LANES - 1) / LANES;
+    if (hints && hints->size() != groups)
+      hints->assign(groups, 0);
+
+    for (std::size_t g = 0; g < groups; ++g)
+    {
+      const std::size_t base = g * LANES;
+      const int first = hints ? (*hints)[g] : 0;
+      int rejected = 0;
+      // The hinted plane first, then the others in order
+      for (int k = 0; k < 6 && rejected != 0xF; ++k)
+      {
+        const int plane = k == 0 ? first : (k - 1 < first ? k - 1 : k);
+        rejected |= outside(plane, base);
+        if (rejected == 0xF && hints)
+          (*hints)[g] = static_cast<std::uint8_t>(plane);
+      }
+
+      // Lanes past `count` are padding
+      const std::size_t lanes = std::min(LANES, count - base);
+      for (std::size_t lane = 0; lane < lanes; ++lane)
+      {
+        if ((rejected >> lane & 1) == 0)
+          visible.push_back(static_cast<std::uint32_t>(base + lane));
+      }
+    }
+  }
+
+  template <typename Array>
+  void pushPadded(Array &array, std::size_t count, float value)
+  {
+    if (count % LANES == 0)
+      array.resize(count + LANES, 0.0f);
+    array[count] = value;
+  }
+}
+
+void AABBArrays::clear()
+{
+  for (auto *array : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ})
+    array->clear();
+  count = 0;
+}
+
+void AABBArrays::push(const glm::vec3 &min, const glm::vec3 &max)
+{
+  pushPadded(minX, count, min.x);
+  pushPadded(minY, count, min.y);
+  pushPadded(minZ, count, min.z);
+  pushPadded(maxX, count, max.x);
+  pushPadded(maxY, count, max.y);
+  pushPadded(maxZ, count, max.z);
+  ++count;
+}
+
+void SphereArrays::clear()
+{
+  for (auto *array : {&x, &y, &z, &radius})
+    array->clear();
+  count = 0;
+}
+
+void SphereArrays::push(const glm::vec3 &center, float r)
+{
+  pushPadded(x, count, center.x);
+  pushPadded(y, count, center.y);
+  pushPadded(z, count, center.z);
+  pushPadded(radius, count, r);
+  ++count;
+}
+
 void Frustum::update(const glm::mat4 &viewProjMatrix)
 {
   glm::mat4 m = glm::transpose(viewProjMatrix);
@@ -57,4 +146,118 @@ bool Frustum::isAABBInFrustum(const glm::vec3 &min, const glm::vec3 &max) const
     }
   }
   return true;
-}
\ No newline at end of file
+}
+
+void Cone::update(const glm::vec3 &apex_, const glm::vec3 &axis_, float halfAngleRadians, float range_)
+{
+  apex = apex_;
+  axis = glm::normalize(axis_);
+  sinAngle = std::sin(halfAngleRadians);
+  cosAngle = std::cos(halfAngleRadians);
+  range = range_;
+}
+
+bool Cone::isSphereInCone(const glm::vec3 &center, float radius) const
+{
+  glm::vec3 v = center - apex;
+  float alongAxis = glm::dot(v, axis);
+
+  // Behind the apex or past the far cap
+  if (alongAxis < -radius || alongAxis > range + radius)
+    return false;
+
+  // Signed distance from the center to the cone's side: rotate the
+  // (along, across) coordinates of the center into the side's frame
+  float across = std::sqrt(std::max(glm::dot(v, v) - alongAxis * alongAxis, 0.0f));
+  float sideDistance = cosAngle * across - sinAngle * alongAxis;
+  return sideDistance <= radius;
+}
+
+#if defined(__SSE2__)
+
+void Frustum::cullAABBs(const AABBArrays &bounds, std::vector<std::uint32_t> &visible, std::vector<std::uint8_t> *hints) const
+{
+  // Per plane: broadcast coefficients, and for each axis the bound (min or
+  // max) that lies furthest along the normal, as in isAABBInFrustum
+  __m128 a[6], b[6], c[6], d[6];
+  const float *px[6], *py[6], *pz[6];
+  for (int i = 0; i < 6; i++)
+  {
+    a[i] = _mm_set1_ps(planes[i].x);
+    b[i] = _mm_set1_ps(planes[i].y);
+    c[i] = _mm_set1_ps(planes[i].z);
+    d[i] = _mm_set1_ps(planes[i].w);
+    px[i] = planes[i].x >= 0 ? bounds.maxX.data() : bounds.minX.data();
+    py[i] = planes[i].y >= 0 ? bounds.maxY.data() : bounds.minY.data();
+    pz[i] = planes[i].z >= 0 ? bounds.maxZ.data() : bounds.minZ.data();
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  cullGroups(bounds.count, [&](int i, std::size_t base) {
+    __m128 distance = _mm_mul_ps(a[i], _mm_loadu_ps(px[i] + base));
+    distance = _mm_add_ps(distance, _mm_mul_ps(b[i], _mm_loadu_ps(py[i] + base)));
+    distance = _mm_add_ps(distance, _mm_mul_ps(c[i], _mm_loadu_ps(pz[i] + base)));
+    distance = _mm_add_ps(distance, d[i]);
+    return _mm_movemask_ps(_mm_cmplt_ps(distance, zero));
+  }, visible, hints);
+}
+
+void Frustum::cullSpheres(const SphereArrays &bounds, std::vector<std::uint32_t> &visible, std::vector<std::uint8_t> *hints) const
+{
+  __m128 a[6], b[6], c[6], d[6];
+  for (int i = 0; i < 6; i++)
+  {
+    a[i] = _mm_set1_ps(planes[i].x);
+    b[i] = _mm_set1_ps(planes[i].y);
+    c[i] = _mm_set1_ps(planes[i].z);
+    d[i] = _mm_set1_ps(planes[i].w);
+  }
+
+  const __m128 zero = _mm_setzero_ps();
+  cullGroups(bounds.count, [&](int i, std::size_t base) {
+    __m128 distance = _mm_mul_ps(a[i], _mm_loadu_ps(bounds.x.data() + base));
+    distance = _mm_add_ps(distance, _mm_mul_ps(b[i], _mm_loadu_ps(bounds.y.data() + base)));
+    distance = _mm_add_ps(distance, _mm_mul_ps(c[i], _mm_loadu_ps(bounds.z.data() + base)));
+    distance = _mm_add_ps(distance, d[i]);
+    // Outside when distance < -radius
+    distance = _mm_add_ps(distance, _mm_loadu_ps(bounds.radius.data() + base));
+    return _mm_movemask_ps(_mm_cmplt_ps(distance, zero));
+  }, visible, hints);
+}
+
+#else
+
+// Same tests without SSE, one lane at a time
+void Frustum::cullAABBs(const AABBArrays &bounds, std::vector<std::uint32_t> &visible, std::vector<std::uint8_t> *hints) const
+{
+  cullGroups(bounds.count, [&](int i, std::size_t base) {
+    int mask = 0;
+    for (std::size_t lane = 0; lane < LANES; ++lane)
+    {
+      const std::size_t k = base + lane;
+      const float x = planes[i].x >= 0 ? bounds.maxX[k] : bounds.minX[k];
+      const float y = planes[i].y >= 0 ? bounds.maxY[k] : bounds.minY[k];
+      const float z = planes[i].z >= 0 ? bounds.maxZ[k] : bounds.minZ[k];
+      if (planes[i].x * x + planes[i].y * y + planes[i].z * z + planes[i].w < 0)
+        mask |= 1 << lane;
+    }
+    return mask;
+  }, visible, hints);
+}
+
+void Frustum::cullSpheres(const SphereArrays &bounds, std::vector<std::uint32_t> &visible, std::vector<std::uint8_t> *hints) const
+{
+  cullGroups(bounds.count, [&](int i, std::size_t base) {
+    int mask = 0;
+    for (std::size_t lane = 0; lane < LANES; ++lane)
+    {
+      const std::size_t k = base + lane;
+      const float distance = planes[i].x * bounds.x[k] + planes[i].y * bounds.y[k] + planes[i].z * bounds.z[k] + planes[i].w;
+      if (distance < -bounds.radius[k])
+        mask |= 1 << lane;
+    }
+    return mask;
+  }, visible, hints);
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include <GBuffer.hpp>
+#include <GLState.hpp>
+
+#include <BSlogger.hpp>
+
+GBuffer::GBuffer(GLsizei _width, GLsizei _height) noexcept
+    : width{_width}, height{_height}
+{
+    glGenTextures(1, &albedo);
+    glGenTextures(1, &normal);
+    glGenTextures(1, &depth);
+    for (GLuint texture : {albedo, normal, depth})
+    {
+        // Read with texelFetch, one texel per pixel
+        GLState::bind_texture(0, GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    allocate();
+
+    glGenFramebuffers(1, &fbo);
+    GLState::bind_framebuffer(fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+    const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, draw_buffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_INIT_CERR();
+        log(LOG_ERR) << "GBuffer: framebuffer not complete\n";
+    }
+    GLState::bind_framebuffer(0);
+}
+
+GBuffer::~GBuffer()
+{
+    for (GLuint texture : {albedo, normal, depth})
+        GLState::forget_texture(texture);
+    GLState::forget_framebuffer(fbo);
+    if (albedo) glDeleteTextures(1, &albedo);
+    if (normal) glDeleteTextures(1, &normal);
+    if (depth) glDeleteTextures(1, &depth);
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+}
+
+void GBuffer::resize(GLsizei _width, GLsizei _height) noexcept
+{
+    if (_width == width && _height == height)
+        return;
+    width = _width;
+    height = _height;
+    allocate();
+}
+
+void GBuffer::begin() const noexcept
+{
+    GLState::bind_framebuffer(fbo);
+    glViewport(0, 0, width, height);
+    // Depth 1 marks pixels nothing was drawn to; the color is not read there
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GBuffer::bind_textures(GLuint first_unit) const noexcept
+{
+    GLState::bind_texture(first_unit, GL_TEXTURE_2D, albedo);
+    GLState::bind_texture(first_unit + 1, GL_TEXTURE_2D, normal);
+    GLState::bind_texture(first_unit + 2, GL_TEXTURE_2D, depth);
+}
+
+void GBuffer::allocate() noexcept
+{
+    // Attachments keep their names, so the FBO needs no update
+    GLState::bind_texture(0, GL_TEXTURE_2D, albedo);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    GLState::bind_texture(0, GL_TEXTURE_2D, normal);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    GLState::bind_texture(0, GL_TEXTURE_2D, depth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+}
@@ -0,0 +1,138 @@
+#include <GLState.hpp>
+
+namespace
+{
+    std::array<GLuint, GLState::MAX_TEXTURE_UNITS> unknown_units() noexcept
+    {
+        std::array<GLuint, GLState::MAX_TEXTURE_UNITS> units;
+        units.fill(~0u);
+        return units;
+    }
+}
+
+GLuint GLState::program{GLState::UNKNOWN};
+GLuint GLState::vertex_array{GLState::UNKNOWN};
+GLuint GLState::framebuffer{GLState::UNKNOWN};
+GLuint GLState::active_unit{GLState::UNKNOWN};
+std::array<GLuint, GLState::MAX_TEXTURE_UNITS> GLState::textures_2d{unknown_units()};
+std::array<GLuint, GLState::MAX_TEXTURE_UNITS> GLState::textures_cube{unknown_units()};
+std::array<GLuint, GLState::MAX_TEXTURE_UNITS> GLState::textures_buffer{unknown_units()};
+std::size_t GLState::issued{0};
+std::size_t GLState::skipped{0};
+
+void GLState::use_program(GLuint _program) noexcept
+{
+    if (program == _program)
+    {
+        ++skipped;
+        return;
+    }
+    program = _program;
+    ++issued;
+    glUseProgram(program);
+}
+
+void GLState::bind_vertex_array(GLuint _vertex_array) noexcept
+{
+    if (vertex_array == _vertex_array)
+    {
+        ++skipped;
+        return;
+    }
+    vertex_array = _vertex_array;
+    ++issued;
+    glBindVertexArray(vertex_array);
+}
+
+void GLState::bind_framebuffer(GLuint _framebuffer) noexcept
+{
+    if (framebuffer == _framebuffer)
+    {
+        ++skipped;
+        return;
+    }
+    framebuffer = _framebuffer;
+    ++issued;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GLState::bind_texture(GLuint unit, GLenum target, GLuint texture) noexcept
+{
+    if (unit >= MAX_TEXTURE_UNITS)
+    {
+        // Untracked unit: always forward
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        active_unit = unit;
+        issued += 2;
+        return;
+    }
+
+    GLuint& bound = target == GL_TEXTURE_CUBE_MAP ? textures_cube[unit]
+                  : target == GL_TEXTURE_BUFFER ? textures_buffer[unit]
+                  : textures_2d[unit];
+    if (bound == texture)
+    {
+        ++skipped;
+        return;
+    }
+
+    if (active_unit != unit)
+    {
+        active_unit = unit;
+        ++issued;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    bound = texture;
+    ++issued;
+    glBindTexture(target, texture);
+}
+
+void GLState::forget_program(GLuint _program) noexcept
+{
+    if (program == _program)
+        program = UNKNOWN;
+}
+
+void GLState::forget_vertex_array(GLuint _vertex_array) noexcept
+{
+    if (vertex_array == _vertex_array)
+        vertex_array = UNKNOWN;
+}
+
+void GLState::forget_framebuffer(GLuint _framebuffer) noexcept
+{
+    if (framebuffer == _framebuffer)
+        framebuffer = UNKNOWN;
+}
+
+void GLState::forget_texture(GLuint texture) noexcept
+{
+    for (GLuint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit)
+    {
+        if (textures_2d[unit] == texture)
+            textures_2d[unit] = UNKNOWN;
+        if (textures_cube[unit] == texture)
+            textures_cube[unit] = UNKNOWN;
+        if (textures_buffer[unit] == texture)
+            textures_buffer[unit] = UNKNOWN;
+    }
+}
+
+void GLState::invalidate() noexcept
+{
+    program = UNKNOWN;
+    vertex_array = UNKNOWN;
+    framebuffer = UNKNOWN;
+    active_unit = UNKNOWN;
+    textures_2d.fill(UNKNOWN);
+    textures_cube.fill(UNKNOWN);
+    textures_buffer.fill(UNKNOWN);
+}
+
+void GLState::reset_counters() noexcept
+{
+    issued = 0;
+    skipped = 0;
+}
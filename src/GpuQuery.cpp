@@ -0,0 +1,68 @@
+#include <GpuQuery.hpp>
+
+GpuQuery::GpuQuery(GLenum _target) noexcept
+    : target{_target}
+{
+    glGenQueries(static_cast<GLsizei>(ids.size()), ids.data());
+}
+
+GpuQuery::~GpuQuery()
+{
+    if (ids[0] != 0)
+    {
+        glDeleteQueries(static_cast<GLsizei>(ids.size()), ids.data());
+        ids.fill(0);
+    }
+}
+
+void GpuQuery::begin() noexcept
+{
+    collect();
+
+    // The GPU is more than LATENCY frames behind: skip this measurement
+    // rather than wait for the slot
+    active = pending[next] ? LATENCY : next;
+    if (active == LATENCY)
+        return;
+
+    glBeginQuery(target, ids[active]);
+    next = (next + 1) % LATENCY;
+}
+
+void GpuQuery::end() noexcept
+{
+    if (active == LATENCY)
+        return;
+
+    glEndQuery(target);
+    pending[active] = true;
+    active = LATENCY;
+}
+
+void GpuQuery::reset_totals() noexcept
+{
+    total = 0;
+    count = 0;
+}
+
+void GpuQuery::collect() noexcept
+{
+    for (std::size_t i = 0; i < LATENCY; ++i)
+    {
+        const std::size_t slot = (next + i) % LATENCY;
+        if (!pending[slot])
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(ids[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 value = 0;
+        glGetQueryObjectui64v(ids[slot], GL_QUERY_RESULT, &value);
+        result = value;
+        total += value;
+        ++count;
+        pending[slot] = false;
+    }
+}
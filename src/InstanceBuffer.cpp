@@ -0,0 +1,66 @@
+#include <InstanceBuffer.hpp>
+#include <Transform.hpp>
+
+#include <cstring>
+
+InstanceBuffer::Instance::Instance(const glm::mat4& _model) noexcept
+    : model{_model}
+{
+    const glm::mat3 normal_3x3 = normal_matrix(model);
+    for (int column = 0; column < 3; ++column)
+        normal[column] = glm::vec4(normal_3x3[column], 0.0f);
+}
+
+InstanceBuffer::InstanceBuffer(std::size_t _capacity) noexcept
+{
+    glGenBuffers(1, &buffer_id);
+    allocate(_capacity);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    if (buffer_id != 0)
+    {
+        glDeleteBuffers(1, &buffer_id);
+        buffer_id = 0;
+    }
+}
+
+std::size_t InstanceBuffer::write(const Instance* instances, std::size_t count) noexcept
+{
+    if (count > capacity)
+    {
+        allocate(count * 2);
+    }
+    else if (cursor + count > capacity)
+    {
+        // Orphan: the driver hands us fresh storage while earlier draws keep
+        // reading the old one
+        allocate(capacity);
+    }
+
+    const std::size_t first = cursor;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    void* destination = glMapBufferRange(GL_ARRAY_BUFFER, first * sizeof(Instance), count * sizeof(Instance),
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (destination)
+    {
+        std::memcpy(destination, instances, count * sizeof(Instance));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    cursor += count;
+    return first;
+}
+
+void InstanceBuffer::allocate(std::size_t new_capacity) noexcept
+{
+    capacity = new_capacity;
+    cursor = 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
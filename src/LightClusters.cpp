@@ -0,0 +1,324 @@
+#include <LightClusters.hpp>
+#include <Frustum.hpp>
+#include <GLState.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <BSlogger.hpp>
+
+LightClusters::LightClusters(unsigned _tiles_x, unsigned _tiles_y, unsigned _slices) noexcept
+    : tiles_x{std::max(_tiles_x, 1u)}, tiles_y{std::max(_tiles_y, 1u)}, slices{std::max(_slices, 1u)},
+      cluster_count{std::size_t{tiles_x} * tiles_y * slices}
+{
+    GLuint buffers[3];
+    glGenBuffers(3, buffers);
+    light_buffer = buffers[0];
+    table_buffer = buffers[1];
+    index_buffer = buffers[2];
+
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    light_texture = textures[0];
+    table_texture = textures[1];
+    index_texture = textures[2];
+
+    // Buffer textures read the buffer object, not a copy, so the storage can
+    // be respecified every frame without attaching it again
+    const struct { GLuint texture; GLenum format; GLuint buffer; } views[] = {
+        {light_texture, GL_RGBA32F, light_buffer},
+        {table_texture, GL_RG32UI, table_buffer},
+        {index_texture, GL_R16UI, index_buffer},
+    };
+    for (const auto& view : views)
+    {
+        upload(view.buffer, nullptr, 0);
+        GLState::bind_texture(0, GL_TEXTURE_BUFFER, view.texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, view.format, view.buffer);
+    }
+}
+
+LightClusters::~LightClusters()
+{
+    for (GLuint texture : {light_texture, table_texture, index_texture})
+        GLState::forget_texture(texture);
+
+    const GLuint textures[] = {light_texture, table_texture, index_texture};
+    glDeleteTextures(3, textures);
+    const GLuint buffers[] = {light_buffer, table_buffer, index_buffer};
+    glDeleteBuffers(3, buffers);
+}
+
+float LightClusters::effective_range(const glm::vec4& attenuation, float peak) noexcept
+{
+    // Solve peak / (c + l*d + q*d^2) = CUTOFF for d
+    const float c = attenuation.x - peak / CUTOFF;
+    const float l = attenuation.y;
+    const float q = attenuation.z;
+    if (c >= 0.0f)
+        return 0.0f;
+    if (q > 0.0f)
+        return (-l + std::sqrt(l * l - 4.0f * q * c)) / (2.0f * q);
+    if (l > 0.0f)
+        return -c / l;
+    return std::numeric_limits<float>::max();
+}
+
+void LightClusters::clear() noexcept
+{
+    lights.clear();
+    volumes.clear();
+}
+
+bool LightClusters::add(const PointLightData& light, int shadow) noexcept
+{
+    // A point light is stored as a spot without a cone
+    SpotLightData data;
+    data.position = light.position;
+    data.direction = glm::vec4{0.0f, 0.0f, 0.0f, 0.0f};
+    data.ambient = light.ambient;
+    data.diffuse = light.diffuse;
+    data.specular = light.specular;
+    data.attenuation = light.attenuation;
+    data.cone = glm::vec4{-1.0f, -1.0f, 0.0f, 0.0f};
+    return push(data, false, shadow);
+}
+
+bool LightClusters::add(const SpotLightData& light, int shadow) noexcept
+{
+    return push(light, true, shadow);
+}
+
+bool LightClusters::push(const SpotLightData& light, bool spot, int shadow) noexcept
+{
+    if (lights.size() >= MAX_LIGHTS)
+    {
+        LOG_INIT_CERR();
+        log(LOG_ERR) << "LightClusters: more than " << MAX_LIGHTS << " lights, the rest are dropped\n";
+        return false;
+    }
+
+    const glm::vec3 peak = glm::vec3(light.ambient) + glm::vec3(light.diffuse) + glm::vec3(light.specular);
+    Volume volume;
+    volume.position = glm::vec3(light.position);
+    volume.range = effective_range(light.attenuation, std::max(peak.x, std::max(peak.y, peak.z)));
+    volume.spot = spot;
+    if (spot)
+    {
+        volume.direction = glm::normalize(glm::vec3(light.direction));
+        volume.cos_angle = light.cone.y;
+    }
+
+    // Range in position.w (the shader stops there too), the shadow map in
+    // direction.w and the kind of light in attenuation.w
+    SpotLightData data = light;
+    data.position.w = volume.range;
+    data.direction.w = static_cast<float>(shadow);
+    data.attenuation.w = spot ? 1.0f : 0.0f;
+    lights.push_back(data);
+    volumes.push_back(volume);
+    return true;
+}
+
+void LightClusters::update(const glm::mat4& view, const glm::mat4& projection, GLsizei width, GLsizei height) noexcept
+{
+    if (projection != grid_projection)
+        build_grid(projection);
+    tiles_per_pixel = glm::vec2(static_cast<float>(tiles_x) / std::max(width, 1), static_cast<float>(tiles_y) / std::max(height, 1));
+
+    pairs.clear();
+    for (std::size_t light = 0; light < volumes.size(); ++light)
+    {
+        const Volume& volume = volumes[light];
+        if (volume.range <= 0.0f)
+            continue;
+
+        // View-space bounding sphere of the light's volume. A cone narrower
+        // than 45 degrees fits in the sphere through its apex and rim.
+        glm::vec3 center = volume.position;
+        float radius = volume.range;
+        Cone cone;
+        if (volume.spot)
+        {
+            const float cos_angle = std::max(volume.cos_angle, 0.0f);
+            const float sin_angle = std::sqrt(1.0f - cos_angle * cos_angle);
+            if (cos_angle > 0.70710678f)
+            {
+                radius = volume.range / (2.0f * cos_angle);
+                center = volume.position + volume.direction * radius;
+            }
+            else if (cos_angle > 0.0f)
+            {
+                radius = volume.range * sin_angle;
+                center = volume.position + volume.direction * (volume.range * cos_angle);
+            }
+            cone.update(glm::vec3(view * glm::vec4(volume.position, 1.0f)), glm::mat3(view) * volume.direction,
+                        std::acos(glm::clamp(volume.cos_angle, -1.0f, 1.0f)), volume.range);
+        }
+        const glm::vec3 view_center = glm::vec3(view * glm::vec4(center, 1.0f));
+        const glm::vec3 light_center = glm::vec3(view * glm::vec4(volume.position, 1.0f));
+
+        // Depth slices, then screen tiles, the sphere can reach
+        const float nearest = -view_center.z - radius;
+        const float farthest = -view_center.z + radius;
+        if (farthest < near_plane || nearest > far_plane)
+            continue;
+        const int first_slice = slice_of(std::max(nearest, near_plane));
+        const int last_slice = slice_of(std::min(farthest, far_plane));
+
+        int first_x = 0, last_x = static_cast<int>(tiles_x) - 1;
+        int first_y = 0, last_y = static_cast<int>(tiles_y) - 1;
+        if (nearest > near_plane)
+        {
+            // x/depth over the sphere's box is extreme at its corners
+            auto tile_range = [&](float low, float high, float scale, unsigned tiles, int& first, int& last) {
+                float ndc_min = std::numeric_limits<float>::max();
+                float ndc_max = std::numeric_limits<float>::lowest();
+                for (float coordinate : {low, high})
+                {
+                    for (float depth : {nearest, farthest})
+                    {
+                        const float ndc = coordinate * scale / depth;
+                        ndc_min = std::min(ndc_min, ndc);
+                        ndc_max = std::max(ndc_max, ndc);
+                    }
+                }
+                ndc_min = glm::clamp(ndc_min, -2.0f, 2.0f);
+                ndc_max = glm::clamp(ndc_max, -2.0f, 2.0f);
+                first = std::max(first, static_cast<int>(std::floor((ndc_min * 0.5f + 0.5f) * tiles)));
+                last = std::min(last, static_cast<int>(std::floor((ndc_max * 0.5f + 0.5f) * tiles)));
+            };
+            tile_range(view_center.x - radius, view_center.x + radius, projection[0][0], tiles_x, first_x, last_x);
+            tile_range(view_center.y - radius, view_center.y + radius, projection[1][1], tiles_y, first_y, last_y);
+        }
+
+        for (int z = first_slice; z <= last_slice; ++z)
+        {
+            for (int y = first_y; y <= last_y; ++y)
+            {
+                for (int x = first_x; x <= last_x; ++x)
+                {
+                    const std::size_t cluster = (static_cast<std::size_t>(z) * tiles_y + y) * tiles_x + x;
+                    bool touches;
+                    if (volume.spot)
+                    {
+                        const glm::vec4& sphere = spheres[cluster];
+                        touches = cone.isSphereInCone(glm::vec3(sphere), sphere.w);
+                    }
+                    else
+                    {
+                        const Box& box = boxes[cluster];
+                        const glm::vec3 closest = glm::clamp(light_center, box.min, box.max);
+                        const glm::vec3 offset = closest - light_center;
+                        touches = glm::dot(offset, offset) <= volume.range * volume.range;
+                    }
+                    if (touches)
+                    {
+                        pairs.push_back(static_cast<std::uint32_t>(cluster));
+                        pairs.push_back(static_cast<std::uint32_t>(light));
+                    }
+                }
+            }
+        }
+    }
+
+    // Counting sort by cluster; lights stay in order within a cluster
+    table.assign(2 * cluster_count, 0);
+    for (std::size_t i = 0; i < pairs.size(); i += 2)
+        ++table[2 * pairs[i] + 1];
+    std::uint32_t offset = 0;
+    occupied = 0;
+    max_cluster_lights = 0;
+    for (std::size_t cluster = 0; cluster < cluster_count; ++cluster)
+    {
+        const std::uint32_t count = table[2 * cluster + 1];
+        table[2 * cluster] = offset;
+        table[2 * cluster + 1] = 0;
+        offset += count;
+        occupied += count > 0;
+        max_cluster_lights = std::max<std::size_t>(max_cluster_lights, count);
+    }
+    indices.resize(pairs.size() / 2);
+    for (std::size_t i = 0; i < pairs.size(); i += 2)
+    {
+        std::uint32_t* entry = &table[2 * pairs[i]];
+        indices[entry[0] + entry[1]++] = static_cast<std::uint16_t>(pairs[i + 1]);
+    }
+
+    upload(light_buffer, lights.data(), lights.size() * sizeof(SpotLightData));
+    upload(table_buffer, table.data(), table.size() * sizeof(std::uint32_t));
+    upload(index_buffer, indices.data(), indices.size() * sizeof(std::uint16_t));
+}
+
+void LightClusters::write(LightsBlock& block) const noexcept
+{
+    block.cluster_grid = glm::ivec4(static_cast<int>(tiles_x), static_cast<int>(tiles_y), static_cast<int>(slices),
+                                    static_cast<int>(lights.size()));
+    block.cluster_mapping = glm::vec4(tiles_per_pixel.x, tiles_per_pixel.y, slice_scale, slice_bias);
+}
+
+void LightClusters::bind(GLuint first_unit) const noexcept
+{
+    GLState::bind_texture(first_unit, GL_TEXTURE_BUFFER, light_texture);
+    GLState::bind_texture(first_unit + 1, GL_TEXTURE_BUFFER, table_texture);
+    GLState::bind_texture(first_unit + 2, GL_TEXTURE_BUFFER, index_texture);
+}
+
+void LightClusters::build_grid(const glm::mat4& projection) noexcept
+{
+    grid_projection = projection;
+    near_plane = projection[3][2] / (projection[2][2] - 1.0f);
+    far_plane = projection[3][2] / (projection[2][2] + 1.0f);
+
+    // slice = log(depth / near) / log(far / near) * slices
+    slice_scale = static_cast<float>(slices) / std::log(far_plane / near_plane);
+    slice_bias = -std::log(near_plane) * slice_scale;
+
+    boxes.resize(cluster_count);
+    spheres.resize(cluster_count);
+    for (unsigned z = 0; z < slices; ++z)
+    {
+        const float depths[2] = {near_plane * std::pow(far_plane / near_plane, static_cast<float>(z) / slices),
+                                 near_plane * std::pow(far_plane / near_plane, static_cast<float>(z + 1) / slices)};
+        for (unsigned y = 0; y < tiles_y; ++y)
+        {
+            for (unsigned x = 0; x < tiles_x; ++x)
+            {
+                // The froxel's corners: tile edges in NDC at both depths
+                Box box{glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+                for (float depth : depths)
+                {
+                    for (unsigned corner = 0; corner < 4; ++corner)
+                    {
+                        const float ndc_x = -1.0f + 2.0f * static_cast<float>(x + (corner & 1)) / tiles_x;
+                        const float ndc_y = -1.0f + 2.0f * static_cast<float>(y + (corner >> 1)) / tiles_y;
+                        const glm::vec3 point(ndc_x * depth / projection[0][0], ndc_y * depth / projection[1][1], -depth);
+                        box.min = glm::min(box.min, point);
+                        box.max = glm::max(box.max, point);
+                    }
+                }
+
+                const std::size_t cluster = (static_cast<std::size_t>(z) * tiles_y + y) * tiles_x + x;
+                boxes[cluster] = box;
+                spheres[cluster] = glm::vec4((box.min + box.max) * 0.5f, glm::length(box.max - box.min) * 0.5f);
+            }
+        }
+    }
+}
+
+int LightClusters::slice_of(float depth) const noexcept
+{
+    const int slice = static_cast<int>(std::floor(std::log(depth) * slice_scale + slice_bias));
+    return std::clamp(slice, 0, static_cast<int>(slices) - 1);
+}
+
+void LightClusters::upload(GLuint buffer, const void* data, std::size_t size) const noexcept
+{
+    // Orphan, then fill; never allocate an empty store
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<std::size_t>(size, 16), nullptr, GL_STREAM_DRAW);
+    if (size > 0)
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
@@ -15,14 +15,14 @@ void Lightbulb::render(const std::shared_ptr<Shader>& shader) const
 {
     glm::mat4 model{1.0f};
     model = glm::translate(model, point_light.get_position());
-    glUniformMatrix4fv(glGetUniformLocation(shader->get_program_id(), "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniform3fv(glGetUniformLocation(shader->get_program_id(), "lightColor"), 1, glm::value_ptr(bulb_color));
+    glUniformMatrix4fv(shader->get_uniform_location("model"_uniform), 1, GL_FALSE, glm::value_ptr(model));
+    glUniform3fv(shader->get_uniform_location("lightColor"_uniform), 1, glm::value_ptr(bulb_color));
     mesh->render();
 }
 
-void Lightbulb::use_light(const std::shared_ptr<Shader>& shader, GLuint light_index) const
+void Lightbulb::write_light(PointLightData& data) const
 {
-    point_light.use(shader, light_index);
+    point_light.write(data);
 }
 
 void Lightbulb::set_position(const glm::vec3& p)
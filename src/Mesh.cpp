@@ -1,12 +1,29 @@
 #include <Mesh.hpp>
+#include <InstanceBuffer.hpp>
+#include <GLState.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 
-std::shared_ptr<Mesh> Mesh::create(const std::vector<GLfloat>& vertices, std::vector<unsigned int> indices) noexcept
+#include <cstddef>
+#include <cstring>
+
+static_assert(sizeof(Mesh::PackedVertex) == 24, "PackedVertex must stay tightly packed");
+
+std::shared_ptr<Mesh> Mesh::create(const std::vector<GLfloat>& vertices, std::vector<unsigned int> indices, VertexFormat format) noexcept
 {
-    auto mesh = std::make_shared<Mesh>();
+    std::vector<GLfloat> final_vertices = build_vertices(vertices, indices);
+    std::size_t vertex_count = final_vertices.size() / 11;
 
-    mesh->index_count = indices.size();
+    if (format == VertexFormat::PACKED && can_pack(final_vertices.data(), vertex_count))
+    {
+        std::vector<PackedVertex> packed = pack_vertices(final_vertices.data(), vertex_count);
+        return upload(VertexFormat::PACKED, packed.data(), vertex_count, indices.data(), indices.size());
+    }
+    return upload(VertexFormat::FLOAT, final_vertices.data(), vertex_count, indices.data(), indices.size());
+}
 
+std::vector<GLfloat> Mesh::build_vertices(const std::vector<GLfloat>& vertices, const std::vector<unsigned int>& indices) noexcept
+{
     std::vector<GLfloat> final_vertices;
     std::vector<glm::vec3> tangents(vertices.size() / 8, glm::vec3(0.0f));
 
@@ -76,35 +93,128 @@ std::shared_ptr<Mesh> Mesh::create(const std::vector<GLfloat>& vertices, std::ve
         final_vertices.push_back(t.z);
     }
 
+    return final_vertices;
+}
+
+std::vector<Mesh::PackedVertex> Mesh::pack_vertices(const GLfloat* vertex_data, std::size_t vertex_count) noexcept
+{
+    std::vector<PackedVertex> packed(vertex_count);
+    for (std::size_t i = 0; i < vertex_count; ++i)
+    {
+        const GLfloat* v = vertex_data + i * 11;
+        PackedVertex& p = packed[i];
+        p.position[0] = v[0];
+        p.position[1] = v[1];
+        p.position[2] = v[2];
+        // Normals and tangents are unit vectors, so 10-bit snorm keeps them
+        // within ~0.1 degrees; the shader renormalizes after the transform.
+        p.normal = glm::packSnorm3x10_1x2(glm::vec4(v[3], v[4], v[5], 0.0f));
+        p.uv = glm::packHalf2x16(glm::vec2(v[6], v[7]));
+        p.tangent = glm::packSnorm3x10_1x2(glm::vec4(v[8], v[9], v[10], 0.0f));
+    }
+    return packed;
+}
+
+bool Mesh::can_pack(const GLfloat* vertex_data, std::size_t vertex_count) noexcept
+{
+    for (std::size_t i = 0; i < vertex_count; ++i)
+    {
+        const GLfloat* uv = vertex_data + i * 11 + 6;
+        if (fabs(uv[0]) > 2.0f || fabs(uv[1]) > 2.0f)
+            return false;
+    }
+    return true;
+}
+
+std::size_t Mesh::get_vertex_size(VertexFormat format) noexcept
+{
+    return format == VertexFormat::PACKED ? sizeof(PackedVertex) : sizeof(GLfloat) * 11;
+}
+
+std::shared_ptr<Mesh> Mesh::upload(VertexFormat format, const void* vertex_data, std::size_t vertex_count, const unsigned int* index_data, std::size_t index_count) noexcept
+{
+    auto mesh = std::make_shared<Mesh>();
+
+    mesh->index_count = index_count;
+    mesh->format = format;
+    mesh->vertex_bytes = vertex_count * get_vertex_size(format);
+
     glGenVertexArrays(1, &mesh->VAO_id);
-    glBindVertexArray(mesh->VAO_id);
+    GLState::bind_vertex_array(mesh->VAO_id);
 
     glGenBuffers(1, &mesh->IBO_id);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->IBO_id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(unsigned int), index_data, GL_STATIC_DRAW);
+
+    // Positions (the first 3 floats of either format) go in a tightly
+    // packed block at the head of the buffer, and the other attributes follow
+    // it, still interleaved. Both VAOs read positions from that block, so
+    // depth passes fetch 12 bytes per vertex and no byte is stored twice.
+    const std::size_t vertex_size = get_vertex_size(format);
+    const std::size_t position_size = sizeof(GLfloat) * 3;
+    const std::size_t attribute_size = vertex_size - position_size;
+    const std::size_t attributes_offset = vertex_count * position_size;
+    std::vector<unsigned char> split(mesh->vertex_bytes);
+    const auto* bytes = static_cast<const unsigned char*>(vertex_data);
+    for (std::size_t i = 0; i < vertex_count; ++i)
+    {
+        std::memcpy(split.data() + i * position_size, bytes + i * vertex_size, position_size);
+        std::memcpy(split.data() + attributes_offset + i * attribute_size, bytes + i * vertex_size + position_size, attribute_size);
+    }
 
     glGenBuffers(1, &mesh->VBO_id);
     glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO_id);
-    glBufferData(GL_ARRAY_BUFFER, final_vertices.size() * sizeof(GLfloat), final_vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, mesh->vertex_bytes, split.data(), GL_STATIC_DRAW);
+
+    // Offset of an attribute in the interleaved block, from its offset in the full vertex
+    auto attribute = [&](std::size_t vertex_offset) {
+        return reinterpret_cast<void*>(attributes_offset + vertex_offset - position_size);
+    };
+    const GLsizei stride = static_cast<GLsizei>(attribute_size);
 
-    GLsizei stride = sizeof(GLfloat) * 11; // 3 pos, 3 normal, 2 uv, 3 tangent
     // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(position_size), nullptr);
     glEnableVertexAttribArray(0);
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(GLfloat) * 3));
-    glEnableVertexAttribArray(1);
-    // Texture Coordinate attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(GLfloat) * 6));
-    glEnableVertexAttribArray(2);
-    // Tangent attribute
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(GLfloat) * 8));
-    glEnableVertexAttribArray(3);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (format == VertexFormat::PACKED)
+    {
+        // Normal attribute, expanded to [-1, 1] by the fetch (w is unused)
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, attribute(offsetof(PackedVertex, normal)));
+        glEnableVertexAttribArray(1);
+        // Texture Coordinate attribute
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, attribute(offsetof(PackedVertex, uv)));
+        glEnableVertexAttribArray(2);
+        // Tangent attribute
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, attribute(offsetof(PackedVertex, tangent)));
+        glEnableVertexAttribArray(3);
+    }
+    else
+    {
+        // Offsets in the full 11-float vertex: 3 pos, 3 normal, 2 uv, 3 tangent
+        // Normal attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, attribute(sizeof(GLfloat) * 3));
+        glEnableVertexAttribArray(1);
+        // Texture Coordinate attribute
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, attribute(sizeof(GLfloat) * 6));
+        glEnableVertexAttribArray(2);
+        // Tangent attribute
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, attribute(sizeof(GLfloat) * 8));
+        glEnableVertexAttribArray(3);
+    }
+
+    // The element buffer binding is part of the VAO, so it stays bound
+    GLState::bind_vertex_array(0);
+
+    // Same buffer and indices, position block only
+    glGenVertexArrays(1, &mesh->depth_VAO_id);
+    GLState::bind_vertex_array(mesh->depth_VAO_id);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->IBO_id);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(position_size), nullptr);
+    glEnableVertexAttribArray(0);
 
-    glBindVertexArray(0);
+    GLState::bind_vertex_array(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     return mesh;
 }
@@ -114,17 +224,68 @@ Mesh::~Mesh()
     clear();
 }
 
+// The VAO stays bound after a draw; consecutive draws of the same mesh
+// (e.g. every panel of a wall) then skip the bind entirely.
 void Mesh::render() const noexcept
 {
-    glBindVertexArray(VAO_id);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO_id);
+    GLState::bind_vertex_array(VAO_id);
+    glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, NULL);
+}
+
+void Mesh::render_depth() const noexcept
+{
+    GLState::bind_vertex_array(depth_VAO_id);
     glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, NULL);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+}
+
+void Mesh::render_instanced(const InstanceBuffer& instances, std::size_t first, GLsizei count) const noexcept
+{
+    GLState::bind_vertex_array(VAO_id);
+    bind_instances(instances, first, true);
+    glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, NULL, count);
+}
+
+void Mesh::render_depth_instanced(const InstanceBuffer& instances, std::size_t first, GLsizei count) const noexcept
+{
+    GLState::bind_vertex_array(depth_VAO_id);
+    bind_instances(instances, first, false);
+    glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, NULL, count);
+}
+
+void Mesh::bind_instances(const InstanceBuffer& instances, std::size_t first, bool normals) noexcept
+{
+    using Instance = InstanceBuffer::Instance;
+    const std::size_t base = first * sizeof(Instance);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instances.get_id());
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = InstanceBuffer::ATTRIBUTE_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              reinterpret_cast<void*>(base + offsetof(Instance, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    for (GLuint column = 0; normals && column < 3; ++column)
+    {
+        GLuint location = InstanceBuffer::NORMAL_ATTRIBUTE_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              reinterpret_cast<void*>(base + offsetof(Instance, normal) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void Mesh::clear() noexcept
 {
+    if (depth_VAO_id != 0)
+    {
+        GLState::forget_vertex_array(depth_VAO_id);
+        glDeleteVertexArrays(1, &depth_VAO_id);
+        depth_VAO_id = 0;
+    }
+
     if (IBO_id != 0)
     {
         glDeleteBuffers(1, &IBO_id);
@@ -139,6 +300,7 @@ void Mesh::clear() noexcept
 
     if (VAO_id != 0)
     {
+        GLState::forget_vertex_array(VAO_id);
         glDeleteVertexArrays(1, &VAO_id);
         VAO_id = 0;
     }
@@ -0,0 +1,358 @@
+#include <MeshCache.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <BSlogger.hpp>
+
+namespace
+{
+    constexpr char MAGIC[8] = {'M', 'E', 'S', 'H', 'C', 'C', 'H', '\0'};
+    constexpr std::size_t ALIGNMENT = 16;
+
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t mesh_count;
+        std::uint64_t source_hash;
+        std::uint64_t file_size;
+    };
+
+    struct MeshRecord
+    {
+        float transform[16];
+        float src_min[3];
+        float src_max[3];
+        std::uint32_t vertex_format; // Mesh::VertexFormat
+        std::uint32_t vertex_stride;
+        std::uint32_t vertex_count;
+        std::uint32_t index_count;
+        std::uint32_t albedo_length;
+        std::uint32_t normal_length;
+        std::uint64_t vertex_offset;
+        std::uint64_t index_offset;
+        std::uint64_t albedo_offset;
+        std::uint64_t normal_offset;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FileHeader>);
+    static_assert(std::is_trivially_copyable_v<MeshRecord>);
+
+    std::size_t align_up(std::size_t value) noexcept
+    {
+        return (value + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    void fnv1a(std::uint64_t& hash, const char* data, std::size_t size) noexcept
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+    }
+
+    bool read_file(const std::filesystem::path& file_path, std::string& contents) noexcept
+    {
+        std::ifstream in_stream{file_path, std::ios::binary};
+        if (!in_stream)
+            return false;
+        contents.assign(std::istreambuf_iterator<char>(in_stream), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    // Collect the external buffer files ("uri": "foo.bin") referenced by a
+    // glTF so that editing only the .bin still invalidates the cooked file.
+    std::vector<std::filesystem::path> find_gltf_buffers(const std::string& gltf, const std::filesystem::path& base_dir) noexcept
+    {
+        std::vector<std::filesystem::path> buffers;
+        std::size_t pos = 0;
+        while ((pos = gltf.find("\"uri\"", pos)) != std::string::npos)
+        {
+            std::size_t open = gltf.find('"', pos + 5);
+            if (open == std::string::npos)
+                break;
+            std::size_t close = gltf.find('"', open + 1);
+            if (close == std::string::npos)
+                break;
+
+            std::string uri = gltf.substr(open + 1, close - open - 1);
+            std::filesystem::path uri_path{uri};
+            if (uri.rfind("data:", 0) != 0 && uri_path.extension() == ".bin")
+                buffers.push_back(base_dir / uri_path);
+
+            pos = close + 1;
+        }
+        return buffers;
+    }
+
+    std::string relative_texture(const std::filesystem::path& texture, const std::filesystem::path& base_dir) noexcept
+    {
+        if (texture.empty())
+            return {};
+        return texture.lexically_relative(base_dir).generic_string();
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        munmap(const_cast<std::byte*>(data), size);
+        data = nullptr;
+        size = 0;
+    }
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::filesystem::path& file_path) noexcept
+{
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void* address = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (address == MAP_FAILED)
+        return nullptr;
+
+    auto file = std::make_shared<MappedFile>();
+    file->data = static_cast<const std::byte*>(address);
+    file->size = static_cast<std::size_t>(info.st_size);
+    return file;
+}
+
+std::filesystem::path MeshCache::directory{};
+
+void MeshCache::set_directory(const std::filesystem::path& _directory) noexcept
+{
+    directory = _directory;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec)
+    {
+        LOG_INIT_CERR();
+        log(LOG_WARN) << "MeshCache: cannot create " << directory << ", caching disabled\n";
+        directory.clear();
+    }
+}
+
+std::filesystem::path MeshCache::get_cooked_path(const std::filesystem::path& source) noexcept
+{
+    // Several models share a file name (e.g. scene.gltf), so the name also
+    // carries a hash of the absolute source path.
+    std::error_code ec;
+    std::string absolute = std::filesystem::absolute(source, ec).generic_string();
+    std::uint64_t path_hash = 14695981039346656037ull;
+    fnv1a(path_hash, absolute.data(), absolute.size());
+
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx.meshcache", static_cast<unsigned long long>(path_hash));
+    return directory / (source.stem().string() + suffix);
+}
+
+std::uint64_t MeshCache::hash_source(const std::filesystem::path& source) noexcept
+{
+    std::uint64_t hash = 14695981039346656037ull;
+
+    std::string contents;
+    if (!read_file(source, contents))
+        return 0;
+    fnv1a(hash, contents.data(), contents.size());
+
+    if (source.extension() == ".gltf")
+    {
+        std::string buffer;
+        for (const auto& buffer_path : find_gltf_buffers(contents, source.parent_path()))
+        {
+            if (read_file(buffer_path, buffer))
+                fnv1a(hash, buffer.data(), buffer.size());
+        }
+    }
+
+    return hash;
+}
+
+bool MeshCache::read(const std::filesystem::path& source, AssimpLoader::ModelData& model) noexcept
+{
+    if (directory.empty())
+        return false;
+
+    auto file = MappedFile::open(get_cooked_path(source));
+    if (!file)
+        return false;
+
+    const std::byte* base = file->get_data();
+    const std::size_t size = file->get_size();
+
+    FileHeader header;
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != FORMAT_VERSION || header.file_size != size)
+        return false;
+
+    if (header.source_hash != hash_source(source))
+        return false;
+
+    if (sizeof(header) + std::uint64_t(header.mesh_count) * sizeof(MeshRecord) > size)
+        return false;
+
+    auto in_bounds = [size](std::uint64_t offset, std::uint64_t bytes) {
+        return offset <= size && bytes <= size - offset;
+    };
+
+    const std::filesystem::path base_dir = source.parent_path();
+    std::vector<AssimpLoader::MeshData> meshes(header.mesh_count);
+
+    for (std::uint32_t i = 0; i < header.mesh_count; ++i)
+    {
+        MeshRecord record;
+        std::memcpy(&record, base + sizeof(header) + i * sizeof(MeshRecord), sizeof(record));
+
+        if (record.vertex_format > static_cast<std::uint32_t>(Mesh::VertexFormat::PACKED))
+            return false;
+        const auto format = static_cast<Mesh::VertexFormat>(record.vertex_format);
+
+        if (record.vertex_stride != Mesh::get_vertex_size(format) ||
+            !in_bounds(record.vertex_offset, std::uint64_t(record.vertex_count) * record.vertex_stride) ||
+            !in_bounds(record.index_offset, std::uint64_t(record.index_count) * sizeof(unsigned int)) ||
+            !in_bounds(record.albedo_offset, record.albedo_length) ||
+            !in_bounds(record.normal_offset, record.normal_length) ||
+            record.vertex_offset % ALIGNMENT != 0 || record.index_offset % ALIGNMENT != 0)
+        {
+            return false;
+        }
+
+        AssimpLoader::MeshData& mesh = meshes[i];
+        mesh.format = format;
+        mesh.mapped_vertices = base + record.vertex_offset;
+        mesh.mapped_vertex_count = record.vertex_count;
+        mesh.mapped_indices = reinterpret_cast<const unsigned int*>(base + record.index_offset);
+        mesh.mapped_index_count = record.index_count;
+
+        std::memcpy(&mesh.transform[0][0], record.transform, sizeof(record.transform));
+        mesh.src_min = glm::vec3(record.src_min[0], record.src_min[1], record.src_min[2]);
+        mesh.src_max = glm::vec3(record.src_max[0], record.src_max[1], record.src_max[2]);
+
+        if (record.albedo_length > 0)
+            mesh.albedo_path = base_dir / std::string(reinterpret_cast<const char*>(base + record.albedo_offset), record.albedo_length);
+        if (record.normal_length > 0)
+            mesh.normal_path = base_dir / std::string(reinterpret_cast<const char*>(base + record.normal_offset), record.normal_length);
+    }
+
+    model.path = source;
+    model.meshes = std::move(meshes);
+    model.mapping = std::move(file);
+    model.from_cache = true;
+    return true;
+}
+
+bool MeshCache::write(const std::filesystem::path& source, const AssimpLoader::ModelData& model) noexcept
+{
+    if (directory.empty() || model.meshes.empty())
+        return false;
+
+    const std::filesystem::path base_dir = source.parent_path();
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.mesh_count = model.meshes.size();
+    header.source_hash = hash_source(source);
+
+    // Lay out: header | records | texture path strings | aligned streams
+    std::vector<MeshRecord> records(model.meshes.size());
+    std::vector<std::string> albedo_names(model.meshes.size());
+    std::vector<std::string> normal_names(model.meshes.size());
+
+    std::size_t offset = sizeof(header) + records.size() * sizeof(MeshRecord);
+    for (std::size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        albedo_names[i] = relative_texture(model.meshes[i].albedo_path, base_dir);
+        normal_names[i] = relative_texture(model.meshes[i].normal_path, base_dir);
+        records[i].albedo_offset = offset;
+        records[i].albedo_length = albedo_names[i].size();
+        offset += albedo_names[i].size();
+        records[i].normal_offset = offset;
+        records[i].normal_length = normal_names[i].size();
+        offset += normal_names[i].size();
+    }
+
+    for (std::size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        const AssimpLoader::MeshData& mesh = model.meshes[i];
+        MeshRecord& record = records[i];
+
+        std::memcpy(record.transform, &mesh.transform[0][0], sizeof(record.transform));
+        record.src_min[0] = mesh.src_min.x; record.src_min[1] = mesh.src_min.y; record.src_min[2] = mesh.src_min.z;
+        record.src_max[0] = mesh.src_max.x; record.src_max[1] = mesh.src_max.y; record.src_max[2] = mesh.src_max.z;
+        record.vertex_format = static_cast<std::uint32_t>(mesh.format);
+        record.vertex_stride = Mesh::get_vertex_size(mesh.format);
+        record.vertex_count = mesh.vertex_count();
+        record.index_count = mesh.index_count();
+
+        offset = align_up(offset);
+        record.vertex_offset = offset;
+        offset += mesh.vertex_bytes();
+
+        offset = align_up(offset);
+        record.index_offset = offset;
+        offset += mesh.index_count() * sizeof(unsigned int);
+    }
+    header.file_size = offset;
+
+    std::vector<char> bytes(offset, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + sizeof(header), records.data(), records.size() * sizeof(MeshRecord));
+    for (std::size_t i = 0; i < model.meshes.size(); ++i)
+    {
+        const AssimpLoader::MeshData& mesh = model.meshes[i];
+        const MeshRecord& record = records[i];
+        std::memcpy(bytes.data() + record.albedo_offset, albedo_names[i].data(), albedo_names[i].size());
+        std::memcpy(bytes.data() + record.normal_offset, normal_names[i].data(), normal_names[i].size());
+        std::memcpy(bytes.data() + record.vertex_offset, mesh.vertex_data(), mesh.vertex_bytes());
+        std::memcpy(bytes.data() + record.index_offset, mesh.index_data(), mesh.index_count() * sizeof(unsigned int));
+    }
+
+    // Write to a temporary name and rename so a concurrent reader never maps
+    // a half-written file.
+    std::filesystem::path cooked = get_cooked_path(source);
+    std::filesystem::path temporary = cooked;
+    temporary += ".tmp";
+    {
+        std::ofstream out_stream{temporary, std::ios::binary | std::ios::trunc};
+        if (!out_stream.write(bytes.data(), bytes.size()))
+        {
+            LOG_INIT_CERR();
+            log(LOG_WARN) << "MeshCache: failed to write " << temporary << "\n";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, cooked, ec);
+    return !ec;
+}
@@ -1,7 +1,4 @@
 #include <PointLight.hpp>
-#include <string>
-
-#include <glm/gtc/type_ptr.hpp>
 
 PointLight::PointLight(const glm::vec3& _position,
                        const glm::vec3& _ambient,
@@ -20,15 +17,11 @@ PointLight::PointLight(const glm::vec3& _position,
 {
 }
 
-void PointLight::use(const std::shared_ptr<Shader>& shader, GLuint light_index) const noexcept
+void PointLight::write(PointLightData& data) const noexcept
 {
-    std::string base_uniform = "pointLights[" + std::to_string(light_index) + "]";
-
-    glUniform3fv(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".position").c_str()), 1, glm::value_ptr(position));
-    glUniform3fv(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".ambient").c_str()), 1, glm::value_ptr(ambient));
-    glUniform3fv(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".diffuse").c_str()), 1, glm::value_ptr(diffuse));
-    glUniform3fv(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".specular").c_str()), 1, glm::value_ptr(specular));
-    glUniform1f(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".constant").c_str()), constant);
-    glUniform1f(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".linear").c_str()), linear);
-    glUniform1f(glGetUniformLocation(shader->get_program_id(), (base_uniform + ".quadratic").c_str()), quadratic);
+    data.position = glm::vec4{position, 1.0f};
+    data.ambient = glm::vec4{ambient, 0.0f};
+    data.diffuse = glm::vec4{diffuse, 0.0f};
+    data.specular = glm::vec4{specular, 0.0f};
+    data.attenuation = glm::vec4{constant, linear, quadratic, 0.0f};
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include <PortalGraph.hpp>
+#include <Room.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    // Recursion guard; rectangles only grow, so the walk ends anyway
+    constexpr unsigned MAX_DEPTH = 64;
+
+    // Closer than this to a doorway's plane (e.g. standing in it) the
+    // doorway is not projected and the whole incoming view passes
+    constexpr float DOORWAY_MARGIN = 1.0f;
+
+    // Doors of two rooms are the same opening if their centers are this close
+    constexpr float DOOR_MATCH_DISTANCE = 0.01f;
+}
+
+std::size_t PortalGraph::add_room(const glm::mat4& transform, int door_mask) noexcept
+{
+    Cell cell;
+    cell.min = glm::vec3(std::numeric_limits<float>::max());
+    cell.max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        const glm::vec3 local{corner & 1 ? Room::HALF_EXTENT : -Room::HALF_EXTENT,
+                              corner & 2 ? Room::CEILING_Y : Room::FLOOR_Y,
+                              corner & 4 ? Room::HALF_EXTENT : -Room::HALF_EXTENT};
+        const glm::vec3 world = glm::vec3(transform * glm::vec4(local, 1.0f));
+        cell.min = glm::min(cell.min, world);
+        cell.max = glm::max(cell.max, world);
+    }
+
+    // The outside cell stays last
+    const std::size_t index = cells.size() - 1;
+    cells.insert(cells.begin() + index, cell);
+
+    const float door_y = Room::FLOOR_Y + Room::DOOR_HEIGHT * 0.5f;
+    const struct { int side; glm::vec3 normal; } sides[] = {
+        {Room::DOOR_FRONT, {0.0f, 0.0f, 1.0f}},
+        {Room::DOOR_BACK, {0.0f, 0.0f, -1.0f}},
+        {Room::DOOR_LEFT, {-1.0f, 0.0f, 0.0f}},
+        {Room::DOOR_RIGHT, {1.0f, 0.0f, 0.0f}},
+    };
+    for (const auto& side : sides)
+    {
+        if ((door_mask & side.side) == 0)
+            continue;
+        const glm::vec3 local = side.normal * Room::HALF_EXTENT + glm::vec3(0.0f, door_y, 0.0f);
+        doors.push_back({index, glm::vec3(transform * glm::vec4(local, 1.0f)), glm::normalize(glm::mat3(transform) * side.normal)});
+    }
+    return index;
+}
+
+void PortalGraph::build() noexcept
+{
+    portals.clear();
+    for (Cell& cell : cells)
+        cell.portals.clear();
+
+    std::vector<bool> linked(doors.size(), false);
+    for (std::size_t a = 0; a < doors.size(); ++a)
+    {
+        if (linked[a])
+            continue;
+
+        // A door meeting another room's door opens into that room,
+        // otherwise it opens to the outside
+        std::size_t target = outside();
+        for (std::size_t b = a + 1; b < doors.size(); ++b)
+        {
+            if (!linked[b] && doors[b].cell != doors[a].cell &&
+                glm::length(doors[b].center - doors[a].center) < DOOR_MATCH_DISTANCE &&
+                glm::dot(doors[b].normal, doors[a].normal) < 0.0f)
+            {
+                linked[b] = true;
+                target = doors[b].cell;
+                break;
+            }
+        }
+        linked[a] = true;
+
+        Portal portal;
+        portal.center = doors[a].center;
+        portal.normal = doors[a].normal;
+        portal.cells = {doors[a].cell, target};
+        const glm::vec3 across = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), portal.normal)) * (Room::DOOR_WIDTH * 0.5f);
+        const glm::vec3 up{0.0f, Room::DOOR_HEIGHT * 0.5f, 0.0f};
+        portal.corners = {portal.center - across - up, portal.center + across - up,
+                          portal.center + across + up, portal.center - across + up};
+
+        cells[portal.cells[0]].portals.push_back(portals.size());
+        cells[portal.cells[1]].portals.push_back(portals.size());
+        portals.push_back(portal);
+    }
+}
+
+std::size_t PortalGraph::locate(const glm::vec3& point) const noexcept
+{
+    for (std::size_t i = 0; i + 1 < cells.size(); ++i)
+    {
+        if (glm::all(glm::greaterThanEqual(point, cells[i].min)) && glm::all(glm::lessThanEqual(point, cells[i].max)))
+            return i;
+    }
+    return outside();
+}
+
+void PortalGraph::update(const glm::mat4& _view_projection, const glm::vec3& _eye) noexcept
+{
+    view_projection = _view_projection;
+    eye = _eye;
+
+    for (std::size_t cell : reached)
+        cells[cell].visible = false;
+    reached.clear();
+    portals_tested = 0;
+
+    visit(locate(eye), portals.size(), Rect{}, 0);
+
+    // Crop the camera frustum to each cell's rectangle: scaling clip space
+    // so the rectangle maps to [-1, 1] yields the planes through its edges
+    for (std::size_t index : reached)
+    {
+        Cell& cell = cells[index];
+        const glm::vec2 extent = cell.rect.max - cell.rect.min;
+        glm::mat4 crop{1.0f};
+        crop[0][0] = 2.0f / extent.x;
+        crop[1][1] = 2.0f / extent.y;
+        crop[3][0] = -(cell.rect.max.x + cell.rect.min.x) / extent.x;
+        crop[3][1] = -(cell.rect.max.y + cell.rect.min.y) / extent.y;
+        cell.frustum.update(crop * view_projection);
+    }
+}
+
+void PortalGraph::visit(std::size_t index, std::size_t from_portal, const Rect& rect, unsigned depth) noexcept
+{
+    Cell& cell = cells[index];
+    if (cell.visible)
+    {
+        // Already seen through a rectangle covering this one: nothing new
+        // can be reached from here
+        if (glm::all(glm::lessThanEqual(cell.rect.min, rect.min)) && glm::all(glm::greaterThanEqual(cell.rect.max, rect.max)))
+            return;
+        cell.rect.min = glm::min(cell.rect.min, rect.min);
+        cell.rect.max = glm::max(cell.rect.max, rect.max);
+    }
+    else
+    {
+        cell.visible = true;
+        cell.rect = rect;
+        reached.push_back(index);
+    }
+
+    if (depth >= MAX_DEPTH)
+        return;
+
+    for (std::size_t p : cell.portals)
+    {
+        if (p == from_portal)
+            continue;
+
+        const Portal& portal = portals[p];
+        const bool forward = portal.cells[0] == index;
+        const std::size_t next = forward ? portal.cells[1] : portal.cells[0];
+        const glm::vec3 normal = forward ? portal.normal : -portal.normal;
+
+        // The eye must be on this cell's side of the doorway to look through it
+        const float distance = glm::dot(portal.center - eye, normal);
+        if (distance < -DOORWAY_MARGIN)
+            continue;
+
+        ++portals_tested;
+        Rect through = rect;
+        if (distance > DOORWAY_MARGIN)
+        {
+            Rect projected;
+            if (!project(portal, projected))
+                continue;
+            through.min = glm::max(through.min, projected.min);
+            through.max = glm::min(through.max, projected.max);
+            if (through.min.x >= through.max.x || through.min.y >= through.max.y)
+                continue;
+        }
+
+        visit(next, p, through, depth + 1);
+    }
+}
+
+bool PortalGraph::project(const Portal& portal, Rect& rect) const noexcept
+{
+    // Clip the quad against the near plane (z >= -w) in clip space, then
+    // bound what is left in normalized device coordinates
+    glm::vec4 clip[4];
+    for (int i = 0; i < 4; ++i)
+        clip[i] = view_projection * glm::vec4(portal.corners[i], 1.0f);
+
+    rect.min = glm::vec2(std::numeric_limits<float>::max());
+    rect.max = glm::vec2(std::numeric_limits<float>::lowest());
+    bool any = false;
+    auto add = [&](const glm::vec4& point) {
+        const glm::vec2 ndc = glm::vec2(point.x, point.y) / point.w;
+        rect.min = glm::min(rect.min, ndc);
+        rect.max = glm::max(rect.max, ndc);
+        any = true;
+    };
+
+    for (int i = 0; i < 4; ++i)
+    {
+        const glm::vec4& a = clip[i];
+        const glm::vec4& b = clip[(i + 1) % 4];
+        const float da = a.z + a.w;
+        const float db = b.z + b.w;
+        if (da >= 0.0f)
+            add(a);
+        if ((da >= 0.0f) != (db >= 0.0f))
+            add(a + (b - a) * (da / (da - db)));
+    }
+    if (!any)
+        return false;
+
+    rect.min = glm::clamp(rect.min, glm::vec2(-1.0f), glm::vec2(1.0f));
+    rect.max = glm::clamp(rect.max, glm::vec2(-1.0f), glm::vec2(1.0f));
+    return true;
+}
+
+bool PortalGraph::is_room_visible(std::size_t index) const noexcept
+{
+    const Cell& cell = cells[index];
+    if (cell.visible)
+        return true;
+    const Cell& out = cells[outside()];
+    return out.visible && out.frustum.isAABBInFrustum(cell.min, cell.max);
+}
+
+bool PortalGraph::is_box_visible(const glm::vec3& min, const glm::vec3& max) const noexcept
+{
+    for (std::size_t index : reached)
+    {
+        const Cell& cell = cells[index];
+        if (index == outside())
+            continue;
+        const bool overlaps = glm::all(glm::lessThanEqual(min, cell.max)) && glm::all(glm::greaterThanEqual(max, cell.min));
+        if (overlaps && cell.frustum.isAABBInFrustum(min, max))
+            return true;
+    }
+
+    const Cell& out = cells[outside()];
+    if (!out.visible || !out.frustum.isAABBInFrustum(min, max))
+        return false;
+
+    // Whatever is not entirely inside one room also lies outside
+    for (std::size_t i = 0; i + 1 < cells.size(); ++i)
+    {
+        if (glm::all(glm::greaterThanEqual(min, cells[i].min)) && glm::all(glm::lessThanEqual(max, cells[i].max)))
+            return false;
+    }
+    return true;
+}
@@ -1,23 +1,17 @@
 #include <Room.hpp>
+#include <TextureCache.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <functional>
 
-Room::Room(const std::filesystem::path &root_path, int door_mask)
+Room::Room(const std::filesystem::path &root_path, int _door_mask)
+    : door_mask{_door_mask}
 {
-    // Load textures
-    floor_texture = std::make_shared<Texture>(root_path / "textures" / "floor_albedo.jpg");
-    floor_texture->load();
-
-    floor_normal_texture = std::make_shared<Texture>(root_path / "textures" / "floor_normal.png");
-    floor_normal_texture->load();
-
-    wall_texture = std::make_shared<Texture>(root_path / "textures" / "wall_albedo.jpg");
-    wall_texture->load();
-
-    wall_normal_texture = std::make_shared<Texture>(root_path / "textures" / "wall_normal.png");
-    wall_normal_texture->load();
+    // Load textures (shared between all rooms through the texture cache)
+    floor_texture = TextureCache::get(root_path / "textures" / "floor_albedo.jpg");
+    floor_normal_texture = TextureCache::get(root_path / "textures" / "floor_normal.png");
+    wall_texture = TextureCache::get(root_path / "textures" / "wall_albedo.jpg");
+    wall_normal_texture = TextureCache::get(root_path / "textures" / "wall_normal.png");
 
     // --- Room Geometry ---
 
@@ -48,13 +42,13 @@ Room::Room(const std::filesystem::path &root_path, int door_mask)
         // texture/normal map for all wall panels.
 
         // Common dimensions
-        const float x_min = -10.0f, x_max = 10.0f;
-        const float z_min = -10.0f, z_max = 10.0f;
-        const float y_min = -2.0f, y_max = 8.0f;
+        const float x_min = -HALF_EXTENT, x_max = HALF_EXTENT;
+        const float z_min = -HALF_EXTENT, z_max = HALF_EXTENT;
+        const float y_min = FLOOR_Y, y_max = CEILING_Y;
 
         // Door geometry (centered on wall)
-        const float door_width = 4.0f;
-        const float door_height = 6.0f; // from y_min to y_min + door_height
+        const float door_width = DOOR_WIDTH;
+        const float door_height = DOOR_HEIGHT; // from y_min to y_min + door_height
         const float half_dw = door_width * 0.5f;
         const float door_top = y_min + door_height;
 
@@ -80,7 +74,7 @@ Room::Room(const std::filesystem::path &root_path, int door_mask)
                 // outward normal. This produces 8 vertices and 12 triangles (36
                 // indices) per quad so walls have real thickness and cast
                 // physically-correct shadows.
-                const float wall_thickness = 0.08f; // meters; tweak if needed
+                const float wall_thickness = WALL_THICKNESS;
                 auto addQuadLocal = [&](const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec3 &d,
                                                                 const glm::vec3 &normal, const glm::vec2 &ta, const glm::vec2 &tb, const glm::vec2 &tc, const glm::vec2 &td)
                 {
@@ -295,20 +289,18 @@ Room::Room(const std::filesystem::path &root_path, int door_mask)
 
 void Room::render(const std::shared_ptr<Shader> &shader, const glm::mat4 &model)
 {
-    glUniformMatrix4fv(shader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(model));
+    shader->set_model(model);
 
     // Render floor (more shiny)
-    glUniform1f(glGetUniformLocation(shader->get_program_id(), "material.shininess"), 32.0f);
-    floor_texture->use(); // Binds to GL_TEXTURE0
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, floor_normal_texture->get_id());
+    glUniform1f(shader->get_uniform_location("material.shininess"_uniform), 32.0f);
+    floor_texture->use(0);
+    floor_normal_texture->use(1);
     floor_mesh->render();
 
     // Render ceiling (less shiny)
-    glUniform1f(glGetUniformLocation(shader->get_program_id(), "material.shininess"), 16.0f);
-    wall_texture->use(); // Use the wall's albedo texture
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, wall_normal_texture->get_id()); // Use the wall's normal map
+    glUniform1f(shader->get_uniform_location("material.shininess"_uniform), 16.0f);
+    wall_texture->use(0); // Use the wall's albedo texture
+    wall_normal_texture->use(1); // Use the wall's normal map
     ceiling_mesh->render();
 
         // Render walls (matte). Each wall is a Wall object and may contain
@@ -323,16 +315,37 @@ void Room::render(const std::shared_ptr<Shader> &shader, const glm::mat4 &model)
 
 void Room::render_for_depth(const std::shared_ptr<Shader> &shader, const glm::mat4 &model)
 {
-    glUniformMatrix4fv(shader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(model));
+    shader->set_model(model);
 
     // Render floor and ceiling into the depth map
-    floor_mesh->render();
-    ceiling_mesh->render();
+    floor_mesh->render_depth();
+    ceiling_mesh->render_depth();
 
     // Render only shadow-casting walls (front faces)
     for (const auto &w : shadow_walls)
     {
         if (w)
-            w->render(shader, model);
+            w->render_depth(shader, model);
     }
-}
\ No newline at end of file
+}
+
+void Room::render_depth(const std::shared_ptr<Shader> &shader, const glm::mat4 &model)
+{
+    shader->set_model(model);
+
+    floor_mesh->render_depth();
+    ceiling_mesh->render_depth();
+
+    for (const auto &w : walls)
+    {
+        if (w)
+            w->render_depth(shader, model);
+    }
+}
+
+Bounds Room::bounds(const glm::mat4 &model) noexcept
+{
+    const float margin = WALL_THICKNESS * 0.5f;
+    return Bounds::transformed(glm::vec3{-HALF_EXTENT - margin, FLOOR_Y - margin, -HALF_EXTENT - margin},
+                               glm::vec3{HALF_EXTENT + margin, CEILING_Y + margin, HALF_EXTENT + margin}, model);
+}
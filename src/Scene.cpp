@@ -0,0 +1,204 @@
+#include <Scene.hpp>
+
+#include <algorithm>
+
+Scene::ModelId Scene::add_model(const std::vector<AssimpLoader::Renderable>& renderables) noexcept
+{
+    std::vector<Part> parts;
+    parts.reserve(renderables.size());
+    for (const auto& r : renderables)
+    {
+        parts.push_back(Part{r, r.transform});
+    }
+    return add_model(std::move(parts));
+}
+
+Scene::ModelId Scene::add_model(std::vector<Part> parts) noexcept
+{
+    Model model;
+    model.parts = std::move(parts);
+    models.push_back(std::move(model));
+    return models.size() - 1;
+}
+
+void Scene::add_instance(ModelId model, const glm::mat4& placement, bool dynamic) noexcept
+{
+    instances.push_back(Instance{model, placement, instance_bounds(model, placement), dynamic});
+}
+
+void Scene::set_placement(std::size_t instance, const glm::mat4& placement) noexcept
+{
+    Instance& moved = instances[instance];
+    changes.push_back(moved.bounds);
+
+    moved.placement = placement;
+    moved.bounds = instance_bounds(moved.model, placement);
+    changes.push_back(moved.bounds);
+
+    dynamic_moved = true;
+
+    const Model& model = models[moved.model];
+    for (std::size_t p = 0; p < model.parts.size(); ++p)
+        world[model.first_world + p * model.instance_count + (instance - model.first_instance)] = InstanceBuffer::Instance{placement * model.parts[p].local};
+}
+
+void Scene::build() noexcept
+{
+    // Stable so instances of a model keep their registration order
+    std::stable_sort(instances.begin(), instances.end(), [](const Instance& a, const Instance& b) {
+        return a.model < b.model;
+    });
+
+    world.clear();
+    std::size_t next = 0;
+    for (ModelId id = 0; id < models.size(); ++id)
+    {
+        Model& model = models[id];
+        model.first_instance = next;
+        while (next < instances.size() && instances[next].model == id)
+            ++next;
+        model.instance_count = next - model.first_instance;
+
+        model.first_world = world.size();
+        for (const auto& part : model.parts)
+        {
+            for (std::size_t k = 0; k < model.instance_count; ++k)
+                world.emplace_back(instances[model.first_instance + k].placement * part.local);
+        }
+    }
+
+    std::vector<Bvh::Item> static_items;
+    std::vector<Bvh::Item> dynamic_items;
+    for (std::size_t i = 0; i < instances.size(); ++i)
+    {
+        const Bvh::Item item{instances[i].bounds, static_cast<std::uint32_t>(i)};
+        (instances[i].dynamic ? dynamic_items : static_items).push_back(item);
+    }
+    static_bvh.build(std::move(static_items));
+    dynamic_bvh.build(std::move(dynamic_items));
+    dynamic_moved = false;
+
+    if (!instance_buffer)
+        instance_buffer = std::make_unique<InstanceBuffer>();
+}
+
+Bounds Scene::instance_bounds(ModelId model, const glm::mat4& placement) const noexcept
+{
+    const std::vector<Part>& parts = models[model].parts;
+    if (parts.empty())
+        return Bounds{glm::vec3(placement[3]), glm::vec3(placement[3]), glm::vec3(placement[3]), 0.0f};
+
+    // Source bounds are in the mesh's own space, before the part transform
+    Bounds bounds = Bounds::transformed(parts[0].renderable.src_min, parts[0].renderable.src_max, placement * parts[0].local);
+    for (std::size_t p = 1; p < parts.size(); ++p)
+        bounds.merge(Bounds::transformed(parts[p].renderable.src_min, parts[p].renderable.src_max, placement * parts[p].local));
+    return bounds;
+}
+
+void Scene::refit_dynamic() const noexcept
+{
+    if (!dynamic_moved)
+        return;
+    dynamic_moved = false;
+
+    dynamic_bvh.refit([&](std::uint32_t id, Bounds& bounds) { bounds = instances[id].bounds; });
+    if (!dynamic_bvh.needs_rebuild())
+        return;
+
+    std::vector<Bvh::Item> items;
+    for (std::size_t i = 0; i < instances.size(); ++i)
+    {
+        if (instances[i].dynamic)
+            items.push_back(Bvh::Item{instances[i].bounds, static_cast<std::uint32_t>(i)});
+    }
+    dynamic_bvh.build(std::move(items));
+}
+
+void Scene::gather_bounds(const VisibleSet& set, AABBArrays& out) const noexcept
+{
+    out.clear();
+    for (std::uint32_t i : set.instances)
+        out.push(instances[i].bounds.min, instances[i].bounds.max);
+}
+
+void Scene::select(const VisibleSet& in, const std::vector<std::uint32_t>& positions, VisibleSet& out) const noexcept
+{
+    out.instances.clear();
+    for (std::uint32_t position : positions)
+        out.instances.push_back(in.instances[position]);
+}
+
+void Scene::draw(const VisibleSet& visible, const std::shared_ptr<Shader>& shader, bool depth_only,
+                 const std::shared_ptr<Shader>& flat_shader) noexcept
+{
+    if (visible.instances.empty() || !instance_buffer)
+        return;
+
+    glUniform1i(shader->get_uniform_use_instancing_id(), 1);
+
+    // Pass 0 draws every part, or with a flat variant only the normal-mapped
+    // ones; pass 1 draws the rest with the flat variant
+    const bool split = flat_shader && !depth_only;
+    bool flat_bound = false;
+    for (int pass = 0; pass < (split ? 2 : 1); ++pass)
+    {
+        std::size_t cursor = 0;
+        for (const auto& model : models)
+        {
+            // Visible indices are sorted, so this model's run is contiguous
+            const std::size_t begin = cursor;
+            const std::size_t end_instance = model.first_instance + model.instance_count;
+            while (cursor < visible.instances.size() && visible.instances[cursor] < end_instance)
+                ++cursor;
+
+            const std::size_t count = cursor - begin;
+            if (count == 0 || model.parts.empty())
+                continue;
+
+            for (std::size_t p = 0; p < model.parts.size(); ++p)
+            {
+                const AssimpLoader::Renderable& r = model.parts[p].renderable;
+                if (split && r.has_normal_map == (pass == 1))
+                    continue;
+
+                if (pass == 1 && !flat_bound)
+                {
+                    flat_shader->use();
+                    glUniform1i(flat_shader->get_uniform_use_instancing_id(), 1);
+                    flat_bound = true;
+                }
+
+                const InstanceBuffer::Instance* column = world.data() + model.first_world + p * model.instance_count;
+                const InstanceBuffer::Instance* transforms = column;
+
+                // Everything visible: the baked matrices are already contiguous
+                if (count != model.instance_count)
+                {
+                    scratch.clear();
+                    for (std::size_t i = begin; i < cursor; ++i)
+                        scratch.push_back(column[visible.instances[i] - model.first_instance]);
+                    transforms = scratch.data();
+                }
+
+                std::size_t first = instance_buffer->write(transforms, count);
+
+                if (depth_only)
+                {
+                    r.mesh->render_depth_instanced(*instance_buffer, first, count);
+                    continue;
+                }
+
+                if (r.albedo)
+                    r.albedo->use(0);
+                if (r.normal && pass == 0)
+                    r.normal->use(1);
+                r.mesh->render_instanced(*instance_buffer, first, count);
+            }
+        }
+    }
+
+    if (flat_bound)
+        glUniform1i(flat_shader->get_uniform_use_instancing_id(), 0);
+    shader->use();
+    glUniform1i(shader->get_uniform_use_instancing_id(), 0);
+}
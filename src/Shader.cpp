@@ -1,6 +1,36 @@
+#include <chrono>
+#include <cstdio>
 #include <fstream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#include <glm/gtc/type_ptr.hpp>
 
 #include <Shader.hpp>
+#include <GLState.hpp>
+#include <Transform.hpp>
+
+std::size_t Shader::cached_lookups{0};
+std::size_t Shader::driver_lookups{0};
+
+std::filesystem::path Shader::binary_cache_directory{};
+std::size_t Shader::binary_hits{0};
+std::size_t Shader::binary_misses{0};
+double Shader::binary_hit_ms{0.0};
+double Shader::binary_miss_ms{0.0};
+
+namespace
+{
+    // Cache file layout: this header, then the program binary
+    struct BinaryHeader
+    {
+        std::uint32_t magic;
+        GLenum format;
+    };
+
+    constexpr std::uint32_t BINARY_MAGIC = 0x31424753; // "SGB1"
+}
 
 Shader::~Shader()
 {
@@ -10,7 +40,7 @@ Shader::~Shader()
 std::shared_ptr<Shader> Shader::create_from_strings(std::string_view vertex_shader_code, std::string_view fragment_shader_code) noexcept
 {
     auto shader = std::make_shared<Shader>();
-    shader->create_program(vertex_shader_code, fragment_shader_code);
+    shader->create_program(vertex_shader_code, {}, fragment_shader_code);
     return shader;
 }
 
@@ -21,12 +51,88 @@ std::shared_ptr<Shader> Shader::create_from_files(std::filesystem::path vertex_s
     return create_from_strings(vertex_shader_code, fragment_shader_code);
 }
 
+std::shared_ptr<Shader> Shader::create_from_files(std::filesystem::path vertex_shader_path, std::filesystem::path fragment_shader_path, const ShaderDefines& defines) noexcept
+{
+    std::string vertex_shader_code = specialize(read_file(vertex_shader_path), defines);
+    std::string fragment_shader_code = specialize(read_file(fragment_shader_path), defines);
+    return create_from_strings(vertex_shader_code, fragment_shader_code);
+}
+
+std::shared_ptr<Shader> Shader::create_from_strings(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept
+{
+    auto shader = std::make_shared<Shader>();
+    shader->create_program(vertex_shader_code, geometry_shader_code, fragment_shader_code);
+    return shader;
+}
+
+std::shared_ptr<Shader> Shader::create_from_files(std::filesystem::path vertex_shader_path, std::filesystem::path geometry_shader_path, std::filesystem::path fragment_shader_path) noexcept
+{
+    std::string vertex_shader_code = read_file(vertex_shader_path);
+    std::string geometry_shader_code = read_file(geometry_shader_path);
+    std::string fragment_shader_code = read_file(fragment_shader_path);
+    return create_from_strings(vertex_shader_code, geometry_shader_code, fragment_shader_code);
+}
+
 void Shader::use() const noexcept
 {
-    glUseProgram(program_id);
+    GLState::use_program(program_id);
 }
 
-void Shader::create_program(std::string_view vertex_shader_code, std::string_view fragment_shader_code) noexcept
+void Shader::set_model(const glm::mat4& model) const noexcept
+{
+    glUniformMatrix4fv(uniform_model_id, 1, GL_FALSE, glm::value_ptr(model));
+    if (uniform_normal_matrix_id >= 0)
+        glUniformMatrix3fv(uniform_normal_matrix_id, 1, GL_FALSE, glm::value_ptr(normal_matrix(model)));
+}
+
+void Shader::create_program(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const std::filesystem::path cache_path = binary_path(vertex_shader_code, geometry_shader_code, fragment_shader_code);
+    const bool cached = !cache_path.empty() && load_binary(cache_path);
+    if (!cached)
+    {
+        if (!link_program(vertex_shader_code, geometry_shader_code, fragment_shader_code))
+            return;
+        if (!cache_path.empty())
+            save_binary(cache_path);
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (cached)
+    {
+        ++binary_hits;
+        binary_hit_ms += elapsed.count();
+    }
+    else
+    {
+        ++binary_misses;
+        binary_miss_ms += elapsed.count();
+    }
+
+    // Note: Program validation can trigger warnings about active samplers across programs
+    // in some GL driver implementations. It's safe to skip explicit validation here.
+
+    reflect_uniforms();
+
+    uniform_model_id = get_uniform_location("model"_uniform);
+    uniform_view_id = get_uniform_location("view"_uniform);
+    uniform_projection_id = get_uniform_location("projection"_uniform);
+    uniform_texture_sampler_id = get_uniform_location("texture_sampler"_uniform);
+    uniform_use_instancing_id = get_uniform_location("useInstancing"_uniform);
+    uniform_normal_matrix_id = get_uniform_location("normalMatrix"_uniform);
+
+    // Get new lighting uniform locations
+    uniform_view_position_id = get_uniform_location("viewPosition"_uniform);
+    uniform_material_shininess_id = get_uniform_location("material.shininess"_uniform);
+    uniform_light_direction_id = get_uniform_location("light.direction"_uniform);
+    uniform_light_ambient_id = get_uniform_location("light.ambient"_uniform);
+    uniform_light_diffuse_id = get_uniform_location("light.diffuse"_uniform);
+    uniform_light_specular_id = get_uniform_location("light.specular"_uniform);
+}
+
+bool Shader::link_program(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept
 {
     LOG_INIT_CERR();
 
@@ -35,12 +141,18 @@ void Shader::create_program(std::string_view vertex_shader_code, std::string_vie
     if (!program_id)
     {
         log(LOG_ERR) << "Error creating shaders program\n";
-        return;
+        return false;
     }
 
     create_shader(vertex_shader_code, GL_VERTEX_SHADER);
+    if (!geometry_shader_code.empty())
+        create_shader(geometry_shader_code, GL_GEOMETRY_SHADER);
     create_shader(fragment_shader_code, GL_FRAGMENT_SHADER);
 
+    // Drivers may only keep a retrievable binary when asked before linking
+    if (!binary_cache_directory.empty())
+        glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     glLinkProgram(program_id);
 
     GLint result;
@@ -51,24 +163,242 @@ void Shader::create_program(std::string_view vertex_shader_code, std::string_vie
         GLchar log_text[1024] = { 0 };
         glGetProgramInfoLog(program_id, sizeof(log_text), nullptr, log_text);
         log(LOG_ERR) << "Error linking the program: " << log_text << " \n";
+        return false;
+    }
+
+    return true;
+}
+
+void Shader::set_binary_cache_directory(std::filesystem::path directory) noexcept
+{
+    binary_cache_directory = std::move(directory);
+}
+
+std::filesystem::path Shader::binary_path(std::string_view vertex_shader_code, std::string_view geometry_shader_code, std::string_view fragment_shader_code) noexcept
+{
+    if (binary_cache_directory.empty())
+        return {};
+
+    // A binary only loads into the driver that produced it, so the driver is
+    // part of the key. Queried once: there is a single context.
+    static const std::string driver = [] {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats <= 0)
+            return std::string{};
+
+        std::string identity;
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            const GLubyte* value = glGetString(name);
+            identity += value ? reinterpret_cast<const char*>(value) : "";
+            identity += '\n';
+        }
+        return identity;
+    }();
+    if (driver.empty())
+        return {};
+
+    // The sources are final (includes and defines expanded), so they cover
+    // every variant. Stages are separated so that moving code between them
+    // changes the key.
+    constexpr std::string_view separator{"\0", 1};
+    std::uint64_t hash = uniform_hash(driver);
+    for (std::string_view code : {vertex_shader_code, geometry_shader_code, fragment_shader_code})
+        hash = uniform_hash(separator, uniform_hash(code, hash));
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return binary_cache_directory / name;
+}
+
+bool Shader::load_binary(const std::filesystem::path& path) noexcept
+{
+    std::ifstream in_stream{path, std::ios::binary};
+    if (!in_stream)
+        return false;
+
+    BinaryHeader header{};
+    in_stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in_stream || header.magic != BINARY_MAGIC)
+        return false;
+
+    const std::vector<char> binary{std::istreambuf_iterator<char>{in_stream}, std::istreambuf_iterator<char>{}};
+    if (binary.empty())
+        return false;
+
+    program_id = glCreateProgram();
+    if (!program_id)
+        return false;
+
+    glProgramBinary(program_id, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Driver updates and unknown formats fail here; the caller compiles
+    GLint result = 0;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+    if (!result)
+    {
+        LOG_INIT_CERR();
+        log(LOG_INFO) << "Shader: cached program " << path.filename().string() << " rejected by the driver, compiling\n";
+        glDeleteProgram(program_id);
+        program_id = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void Shader::save_binary(const std::filesystem::path& path) const noexcept
+{
+    LOG_INIT_CERR();
+
+    GLint length = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    BinaryHeader header{BINARY_MAGIC, 0};
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLsizei written = 0;
+    glGetProgramBinary(program_id, length, &written, &header.format, binary.data());
+    if (written <= 0)
+        return;
+
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    if (error)
+    {
+        log(LOG_WARN) << "Shader: cannot create " << path.parent_path() << ": " << error.message() << "\n";
         return;
     }
 
-    // Note: Program validation can trigger warnings about active samplers across programs
-    // in some GL driver implementations. It's safe to skip explicit validation here.
+    // Written aside and renamed, so a run that stops halfway (or another
+    // instance reading the cache) never sees a partial file
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out_stream{temporary, std::ios::binary | std::ios::trunc};
+        out_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_stream.write(binary.data(), written);
+        if (!out_stream)
+        {
+            log(LOG_WARN) << "Shader: cannot write " << temporary << "\n";
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        log(LOG_WARN) << "Shader: cannot write " << path << ": " << error.message() << "\n";
+}
 
-    uniform_model_id = glGetUniformLocation(program_id, "model");
-    uniform_view_id = glGetUniformLocation(program_id, "view");
-    uniform_projection_id = glGetUniformLocation(program_id, "projection");
-    uniform_texture_sampler_id = glGetUniformLocation(program_id, "texture_sampler");
+GLint Shader::get_uniform_location(std::uint64_t name_hash) const noexcept
+{
+    ++cached_lookups;
+    auto location = uniform_locations.find(name_hash);
+    return location == uniform_locations.end() ? -1 : location->second;
+}
 
-    // Get new lighting uniform locations
-    uniform_view_position_id = glGetUniformLocation(program_id, "viewPosition");
-    uniform_material_shininess_id = glGetUniformLocation(program_id, "material.shininess");
-    uniform_light_direction_id = glGetUniformLocation(program_id, "light.direction");
-    uniform_light_ambient_id = glGetUniformLocation(program_id, "light.ambient");
-    uniform_light_diffuse_id = glGetUniformLocation(program_id, "light.diffuse");
-    uniform_light_specular_id = glGetUniformLocation(program_id, "light.specular");
+void Shader::reset_lookup_counters() noexcept
+{
+    cached_lookups = 0;
+    driver_lookups = 0;
+}
+
+bool Shader::bind_uniform_block(const char* block_name, GLuint binding, std::size_t expected_size) const noexcept
+{
+    GLuint block_index = glGetUniformBlockIndex(program_id, block_name);
+    if (block_index == GL_INVALID_INDEX)
+        return false;
+
+    // Drivers may or may not round the block size up to a whole vec4, and
+    // the CPU struct may carry explicit tail padding, so sizes are compared
+    // in vec4s. Any other difference means the struct and the std140 layout
+    // of the block disagree.
+    GLint block_size = 0;
+    glGetActiveUniformBlockiv(program_id, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
+    auto vec4s = [](std::size_t size) { return (size + 15) / 16; };
+    if (vec4s(static_cast<std::size_t>(block_size)) != vec4s(expected_size))
+    {
+        LOG_INIT_CERR();
+        log(LOG_WARN) << "Uniform block " << block_name << " is " << block_size << " bytes in the program but "
+                      << expected_size << " bytes on the CPU\n";
+    }
+
+    glUniformBlockBinding(program_id, block_index, binding);
+    return true;
+}
+
+std::string Shader::specialize(const std::string& source, const ShaderDefines& defines) noexcept
+{
+    if (defines.empty())
+        return source;
+
+    // #version must stay the first statement
+    std::size_t insert_at = 0;
+    if (source.compare(0, 8, "#version") == 0)
+    {
+        const std::size_t line_end = source.find('\n');
+        insert_at = line_end == std::string::npos ? source.size() : line_end + 1;
+    }
+
+    std::string block;
+    for (const std::string& define : defines)
+        block += "#define " + define + "\n";
+
+    std::string specialized = source;
+    specialized.insert(insert_at, block);
+    return specialized;
+}
+
+void Shader::reflect_uniforms() noexcept
+{
+    uniform_locations.clear();
+
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    std::vector<GLchar> name(max_length + 1, '\0');
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program_id, i, name.size(), &length, &size, &type, name.data());
+
+        // Members of uniform blocks have no location
+        GLint location = driver_location(name.data());
+        if (location < 0)
+            continue;
+
+        std::string_view uniform_name{name.data(), static_cast<std::size_t>(length)};
+        uniform_locations[uniform_hash(uniform_name)] = location;
+
+        // Arrays of basic types are reported once, as "name[0]". Register the
+        // bare name and every element so callers can address any of them.
+        constexpr std::string_view first_element = "[0]";
+        if (uniform_name.size() > first_element.size() &&
+            uniform_name.substr(uniform_name.size() - first_element.size()) == first_element)
+        {
+            std::string base{uniform_name.substr(0, uniform_name.size() - first_element.size())};
+            uniform_locations[uniform_hash(base)] = location;
+
+            for (GLint element = 1; element < size; ++element)
+            {
+                std::string element_name = base + "[" + std::to_string(element) + "]";
+                GLint element_location = driver_location(element_name.c_str());
+                if (element_location >= 0)
+                    uniform_locations[uniform_hash(element_name)] = element_location;
+            }
+        }
+    }
+}
+
+GLint Shader::driver_location(const char* name) const noexcept
+{
+    ++driver_lookups;
+    return glGetUniformLocation(program_id, name);
 }
 
 void Shader::create_shader(std::string_view shader_code, GLenum shader_type) noexcept
@@ -104,6 +434,7 @@ void Shader::clear() noexcept
 {
     if (program_id != 0)
     {
+        GLState::forget_program(program_id);
         glDeleteProgram(program_id);
         program_id = 0;
     }
@@ -112,6 +443,9 @@ void Shader::clear() noexcept
     uniform_view_id = 0;
     uniform_model_id = 0;
     uniform_texture_sampler_id = 0;
+    uniform_use_instancing_id = 0;
+    uniform_normal_matrix_id = -1;
+    uniform_locations.clear();
     uniform_view_position_id = 0;
     uniform_material_shininess_id = 0;
     uniform_light_direction_id = 0;
@@ -120,12 +454,18 @@ void Shader::clear() noexcept
     uniform_light_specular_id = 0;
 }
 
-std::string Shader::read_file(const std::filesystem::path& shader_path) noexcept
+std::string Shader::read_file(const std::filesystem::path& shader_path, unsigned depth) noexcept
 {
     LOG_INIT_CERR();
 
     std::string contents{""};
 
+    if (depth > 8)
+    {
+        log(LOG_ERR) << "Includes nested too deeply in " << shader_path << "\n";
+        return "";
+    }
+
     std::ifstream in_stream{shader_path};
 
     if (!in_stream)
@@ -137,6 +477,14 @@ std::string Shader::read_file(const std::filesystem::path& shader_path) noexcept
     std::string line;
     while (std::getline(in_stream, line))
     {
+        static constexpr std::string_view include_directive{"#include \""};
+        if (line.compare(0, include_directive.size(), include_directive) == 0)
+        {
+            const std::size_t end = line.find('"', include_directive.size());
+            const std::string name = line.substr(include_directive.size(), end - include_directive.size());
+            contents.append(read_file(shader_path.parent_path() / name, depth + 1));
+            continue;
+        }
         contents.append(line + "\n");
     }
 
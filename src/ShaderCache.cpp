@@ -0,0 +1,47 @@
+#include <ShaderCache.hpp>
+
+#include <algorithm>
+
+std::unordered_map<std::string, std::weak_ptr<Shader>> ShaderCache::entries{};
+std::size_t ShaderCache::hits{0};
+std::size_t ShaderCache::misses{0};
+
+std::shared_ptr<Shader> ShaderCache::get(const std::filesystem::path& vertex_shader_path, const std::filesystem::path& fragment_shader_path,
+                                         const ShaderDefines& defines) noexcept
+{
+    std::string key = make_key(vertex_shader_path, fragment_shader_path, defines);
+
+    if (auto shader = entries[key].lock())
+    {
+        ++hits;
+        return shader;
+    }
+
+    ++misses;
+    auto shader = Shader::create_from_files(vertex_shader_path, fragment_shader_path, defines);
+    entries[key] = shader;
+    return shader;
+}
+
+std::size_t ShaderCache::get_live_count() noexcept
+{
+    std::size_t count{0};
+    for (const auto& entry : entries)
+    {
+        if (!entry.second.expired())
+            ++count;
+    }
+    return count;
+}
+
+std::string ShaderCache::make_key(const std::filesystem::path& vertex_shader_path, const std::filesystem::path& fragment_shader_path,
+                                  const ShaderDefines& defines) noexcept
+{
+    ShaderDefines sorted = defines;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string key = vertex_shader_path.lexically_normal().string() + '|' + fragment_shader_path.lexically_normal().string();
+    for (const std::string& define : sorted)
+        key += '|' + define;
+    return key;
+}
@@ -0,0 +1,145 @@
+#include <ShadowAtlas.hpp>
+#include <GLState.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+#include <BSlogger.hpp>
+
+namespace
+{
+    GLsizei floor_power_of_two(GLsizei value) noexcept
+    {
+        GLsizei power = 1;
+        while (power * 2 <= value)
+            power *= 2;
+        return power;
+    }
+
+    // Every other bit of `code`, starting at bit 0 (Morton order decode)
+    GLint compact_bits(std::size_t code) noexcept
+    {
+        GLint value = 0;
+        for (int bit = 0; code != 0; ++bit, code >>= 2)
+            value |= static_cast<GLint>(code & 1u) << bit;
+        return value;
+    }
+}
+
+ShadowAtlas::ShadowAtlas(GLsizei _size, GLsizei _min_tile) noexcept
+    : size{_size}, min_tile{_min_tile}
+{
+    glGenTextures(1, &texture);
+    GLState::bind_texture(0, GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    // Samples are clamped to their tile in the shader, so the edge mode only
+    // matters for the outer border of the atlas
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &fbo);
+    GLState::bind_framebuffer(fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        LOG_INIT_CERR();
+        log(LOG_ERR) << "ShadowAtlas: framebuffer not complete\n";
+    }
+    GLState::bind_framebuffer(0);
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+    GLState::forget_texture(texture);
+    GLState::forget_framebuffer(fbo);
+    if (texture) glDeleteTextures(1, &texture);
+    if (fbo) glDeleteFramebuffers(1, &fbo);
+}
+
+bool ShadowAtlas::pack(const std::vector<GLsizei>& requested) noexcept
+{
+    std::vector<GLsizei> sides(requested.size());
+    for (std::size_t i = 0; i < requested.size(); ++i)
+        sides[i] = std::clamp(floor_power_of_two(std::max<GLsizei>(requested[i], 1)), min_tile, get_max_tile());
+
+    // Largest first, ties in request order, so the layout is deterministic
+    std::vector<std::size_t> order(sides.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sides[a] > sides[b]; });
+
+    // Area is counted in minimum-size cells
+    const std::size_t cells_per_side = static_cast<std::size_t>(size / min_tile);
+    const std::size_t capacity = cells_per_side * cells_per_side;
+    auto cells = [&](GLsizei side) {
+        const std::size_t k = static_cast<std::size_t>(side / min_tile);
+        return k * k;
+    };
+    auto used = [&]() {
+        std::size_t total = 0;
+        for (GLsizei side : sides)
+            total += cells(side);
+        return total;
+    };
+
+    // Halve the biggest tiles first (the last requested among equals): that
+    // frees the most space and keeps the sides ordered as requested
+    while (used() > capacity && sides[order.front()] > min_tile)
+    {
+        const GLsizei largest = sides[order.front()];
+        auto last_largest = std::find_if(order.rbegin(), order.rend(), [&](std::size_t i) { return sides[i] == largest; });
+        sides[*last_largest] /= 2;
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sides[a] > sides[b]; });
+    }
+
+    // Tiles are placed along a Z-order curve over the cells. Going from the
+    // largest tile to the smallest, the cursor is always aligned to the
+    // current tile, so each one lands on a free aligned square.
+    std::vector<Tile> layout(sides.size());
+    std::size_t cursor = 0;
+    for (std::size_t i : order)
+    {
+        if (cursor + cells(sides[i]) > capacity)
+        {
+            LOG_INIT_CERR();
+            log(LOG_ERR) << "ShadowAtlas: no room for tile " << i << " of " << sides.size() << "\n";
+            continue;
+        }
+        layout[i].x = compact_bits(cursor) * min_tile;
+        layout[i].y = compact_bits(cursor >> 1) * min_tile;
+        layout[i].size = sides[i];
+        cursor += cells(sides[i]);
+    }
+
+    const bool changed = !std::equal(layout.begin(), layout.end(), tiles.begin(), tiles.end(), [](const Tile& a, const Tile& b) {
+        return a.x == b.x && a.y == b.y && a.size == b.size;
+    });
+    tiles = std::move(layout);
+    return changed;
+}
+
+void ShadowAtlas::begin(std::size_t tile, bool clear) const noexcept
+{
+    const Tile& t = tiles[tile];
+    GLState::bind_framebuffer(fbo);
+    glViewport(t.x, t.y, t.size, t.size);
+    glScissor(t.x, t.y, t.size, t.size);
+    glEnable(GL_SCISSOR_TEST);
+    if (clear)
+        glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void ShadowAtlas::end() const noexcept
+{
+    glDisable(GL_SCISSOR_TEST);
+}
+
+glm::vec4 ShadowAtlas::get_rect(std::size_t tile) const noexcept
+{
+    const Tile& t = tiles[tile];
+    const float inv = 1.0f / static_cast<float>(size);
+    return glm::vec4{t.x * inv, t.y * inv, t.size * inv, t.size * inv};
+}
@@ -0,0 +1,75 @@
+#include <ShadowCache.hpp>
+#include <GLState.hpp>
+
+ShadowCache::ShadowCache(GLenum _target, GLuint _live_texture, GLsizei _size, GLint _live_x, GLint _live_y) noexcept
+    : target{_target}, live_texture{_live_texture}, size{_size}, live_x{_live_x}, live_y{_live_y}
+{
+    // Same (unsized) depth format as the live maps, as blits between depth
+    // buffers require identical formats
+    glGenTextures(1, &static_texture);
+    GLState::bind_texture(0, target, static_texture);
+    if (target == GL_TEXTURE_CUBE_MAP)
+    {
+        for (GLenum face = 0; face < 6; ++face)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &read_fbo);
+    glGenFramebuffers(1, &draw_fbo);
+    for (GLuint fbo : {read_fbo, draw_fbo})
+    {
+        GLState::bind_framebuffer(fbo);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    GLState::bind_framebuffer(0);
+}
+
+ShadowCache::~ShadowCache()
+{
+    GLState::forget_texture(static_texture);
+    GLState::forget_framebuffer(read_fbo);
+    GLState::forget_framebuffer(draw_fbo);
+    if (static_texture) glDeleteTextures(1, &static_texture);
+    if (read_fbo) glDeleteFramebuffers(1, &read_fbo);
+    if (draw_fbo) glDeleteFramebuffers(1, &draw_fbo);
+}
+
+void ShadowCache::store(const glm::vec3& light_position) noexcept
+{
+    copy(live_texture, live_x, live_y, static_texture, 0, 0);
+    stored_position = light_position;
+    valid = true;
+}
+
+void ShadowCache::restore() const noexcept
+{
+    copy(static_texture, 0, 0, live_texture, live_x, live_y);
+}
+
+void ShadowCache::copy(GLuint source, GLint source_x, GLint source_y, GLuint destination, GLint destination_x, GLint destination_y) const noexcept
+{
+    // Bound through GLState as the draw (and read) framebuffer; the read
+    // binding is pointed at read_fbo only for the blits and put back after
+    GLState::bind_framebuffer(draw_fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+
+    const GLenum faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    for (GLenum face = 0; face < faces; ++face)
+    {
+        const GLenum image = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, image, source, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, image, destination, 0);
+        glBlitFramebuffer(source_x, source_y, source_x + size, source_y + size,
+                          destination_x, destination_y, destination_x + size, destination_y + size,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, draw_fbo);
+}
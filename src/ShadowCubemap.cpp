@@ -1,4 +1,5 @@
 #include <ShadowCubemap.hpp>
+#include <GLState.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -10,7 +11,7 @@ ShadowCubemap::ShadowCubemap(unsigned int size, float far_plane_) noexcept
     glGenFramebuffers(1, &depth_map_fbo);
 
     glGenTextures(1, &depth_cubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, depth_cubemap);
+    GLState::bind_texture(0, GL_TEXTURE_CUBE_MAP, depth_cubemap);
     for (unsigned int i = 0; i < 6; ++i) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, map_size, map_size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
     }
@@ -21,21 +22,32 @@ ShadowCubemap::ShadowCubemap(unsigned int size, float far_plane_) noexcept
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
     // Configure framebuffer: no color buffer is drawn to.
-    glBindFramebuffer(GL_FRAMEBUFFER, depth_map_fbo);
+    GLState::bind_framebuffer(depth_map_fbo);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Unbind texture
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLState::bind_framebuffer(0);
 }
 
 ShadowCubemap::~ShadowCubemap()
 {
+    GLState::forget_texture(depth_cubemap);
+    GLState::forget_framebuffer(depth_map_fbo);
     if (depth_cubemap) glDeleteTextures(1, &depth_cubemap);
     if (depth_map_fbo) glDeleteFramebuffers(1, &depth_map_fbo);
 }
 
+void ShadowCubemap::attach_face(unsigned int face) const noexcept
+{
+    GLState::bind_framebuffer(depth_map_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, depth_cubemap, 0);
+}
+
+void ShadowCubemap::attach_layered() const noexcept
+{
+    GLState::bind_framebuffer(depth_map_fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depth_cubemap, 0);
+}
+
 std::vector<glm::mat4> ShadowCubemap::get_shadow_matrices(const glm::vec3& light_pos, float near_plane) const noexcept
 {
     std::vector<glm::mat4> matrices;
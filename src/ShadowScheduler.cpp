@@ -0,0 +1,75 @@
+#include <ShadowScheduler.hpp>
+
+#include <algorithm>
+#include <utility>
+
+ShadowScheduler::ShadowScheduler(unsigned _face_budget) noexcept
+    : face_budget{_face_budget}
+{
+}
+
+std::size_t ShadowScheduler::add_light(std::string name, unsigned faces) noexcept
+{
+    LightStats light_stats;
+    light_stats.name = std::move(name);
+    light_stats.faces = faces;
+    stats.push_back(std::move(light_stats));
+    pending.emplace_back();
+    return stats.size() - 1;
+}
+
+void ShadowScheduler::request(std::size_t light, float importance, bool required) noexcept
+{
+    Request& r = pending[light];
+    r.required = r.required || required;
+    if (!r.requested)
+    {
+        r.requested = true;
+        r.importance = importance;
+        r.first_frame = frame;
+        return;
+    }
+    r.importance = std::max(r.importance, importance);
+}
+
+const std::vector<std::size_t>& ShadowScheduler::schedule() noexcept
+{
+    order.clear();
+    for (std::size_t light = 0; light < pending.size(); ++light)
+    {
+        if (pending[light].requested)
+            order.push_back(light);
+    }
+
+    // Every frame spent waiting counts as much as the light's own importance
+    auto urgency = [this](std::size_t light) {
+        const Request& r = pending[light];
+        return r.importance * static_cast<float>(1 + frame - r.first_frame);
+    };
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (pending[a].required != pending[b].required)
+            return pending[a].required;
+        return urgency(a) > urgency(b);
+    });
+
+    granted.clear();
+    scheduled_faces = 0;
+    for (std::size_t light : order)
+    {
+        const unsigned faces = stats[light].faces;
+        if (!pending[light].required && !granted.empty() && scheduled_faces + faces > face_budget)
+            continue;
+
+        granted.push_back(light);
+        scheduled_faces += faces;
+
+        LightStats& s = stats[light];
+        ++s.refreshes;
+        s.last_wait = frame - pending[light].first_frame;
+        s.worst_wait = std::max(s.worst_wait, s.last_wait);
+        pending[light] = Request{};
+    }
+
+    ++frame;
+    return granted;
+}
@@ -1,4 +1,5 @@
 #include <SkyBox.hpp>
+#include <GLState.hpp>
 
 const std::filesystem::path& SkyBox::vertex_shader_filename{"skybox.vert"};
 const std::filesystem::path& SkyBox::fragment_shader_filename{"skybox.frag"};
@@ -12,7 +13,7 @@ SkyBox::SkyBox(const std::filesystem::path& root_path, const std::vector<std::fi
 
     // Texture setup
     glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
+    GLState::bind_texture(0, GL_TEXTURE_CUBE_MAP, texture_id);
 
     int width{0};
     int height{0};
@@ -82,6 +83,7 @@ SkyBox::~SkyBox()
 {
     if (texture_id)
     {
+        GLState::forget_texture(texture_id);
         glDeleteTextures(1, &texture_id);
         texture_id = 0;
     }
@@ -99,8 +101,7 @@ void SkyBox::render(const glm::mat4& view, const glm::mat4 projection) const noe
     glUniformMatrix4fv(shader->get_uniform_view_id(), 1, GL_FALSE, glm::value_ptr(the_view));
     glUniformMatrix4fv(shader->get_uniform_projection_id(), 1, GL_FALSE, glm::value_ptr(projection));
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture_id);
+    GLState::bind_texture(0, GL_TEXTURE_CUBE_MAP, texture_id);
 
     mesh->render();
 
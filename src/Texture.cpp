@@ -1,6 +1,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <Texture.hpp>
+#include <GLState.hpp>
 
 Texture::Texture(const std::filesystem::path& _file_path)
     : file_path{_file_path}
@@ -30,7 +31,7 @@ void Texture::load() noexcept
     if (solid_color)
     {
         glGenTextures(1, &id);
-        glBindTexture(GL_TEXTURE_2D, id);
+        GLState::bind_texture(0, GL_TEXTURE_2D, id);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -38,45 +39,56 @@ void Texture::load() noexcept
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, solid_rgba);
-
-        glBindTexture(GL_TEXTURE_2D, 0);
         return;
     }
 
-    // Force 4 channels (RGBA) to ensure consistency
-    unsigned char* tex_data = stbi_load(file_path.c_str(), &width, &height, &bit_depth, 4);
+    load(decode(file_path));
+}
 
-    if (!tex_data)
+void Texture::load(const TextureImage& image) noexcept
+{
+    if (!image.pixels)
     {
         LOG_INIT_CERR();
         log(LOG_ERR) << "Failed to find: " << file_path << "\n";
         return;
     }
 
+    width = image.width;
+    height = image.height;
+    bit_depth = 4;
+
     glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
+    GLState::bind_texture(0, GL_TEXTURE_2D, id);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex_data);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.get());
     glGenerateMipmap(GL_TEXTURE_2D);
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+TextureImage Texture::decode(const std::filesystem::path& file_path) noexcept
+{
+    TextureImage image;
+    int channels{0};
+
+    // Force 4 channels (RGBA) to ensure consistency
+    image.pixels.reset(stbi_load(file_path.c_str(), &image.width, &image.height, &channels, 4));
 
-    stbi_image_free(tex_data);
+    return image;
 }
 
-void Texture::use() const noexcept
+void Texture::use(GLuint unit) const noexcept
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, id);
+    GLState::bind_texture(unit, GL_TEXTURE_2D, id);
 }
 
 void Texture::clear() noexcept
 {
+    GLState::forget_texture(id);
     glDeleteTextures(1, &id);
     id = 0;
     width = 0;
@@ -0,0 +1,99 @@
+#include <TextureCache.hpp>
+
+#include <cstdio>
+#include <system_error>
+
+std::unordered_map<std::string, std::weak_ptr<Texture>> TextureCache::entries{};
+std::size_t TextureCache::hits{0};
+std::size_t TextureCache::misses{0};
+
+std::shared_ptr<Texture> TextureCache::get(const std::filesystem::path& file_path) noexcept
+{
+    std::string key = make_file_key(file_path);
+
+    if (auto texture = entries[key].lock())
+    {
+        ++hits;
+        return texture;
+    }
+
+    ++misses;
+    auto texture = std::make_shared<Texture>(file_path);
+    texture->load();
+    entries[key] = texture;
+    return texture;
+}
+
+std::shared_ptr<Texture> TextureCache::get(const std::filesystem::path& file_path, const TextureImage& decoded) noexcept
+{
+    std::string key = make_file_key(file_path);
+
+    if (auto texture = entries[key].lock())
+    {
+        ++hits;
+        return texture;
+    }
+
+    ++misses;
+    auto texture = std::make_shared<Texture>(file_path);
+    texture->load(decoded);
+    entries[key] = texture;
+    return texture;
+}
+
+std::shared_ptr<Texture> TextureCache::get_solid(unsigned char r, unsigned char g, unsigned char b, unsigned char a) noexcept
+{
+    std::string key = make_solid_key(r, g, b, a);
+
+    if (auto texture = entries[key].lock())
+    {
+        ++hits;
+        return texture;
+    }
+
+    ++misses;
+    auto texture = std::make_shared<Texture>(r, g, b, a);
+    texture->load();
+    entries[key] = texture;
+    return texture;
+}
+
+std::size_t TextureCache::get_live_count() noexcept
+{
+    std::size_t count{0};
+    for (const auto& entry : entries)
+    {
+        if (!entry.second.expired())
+            ++count;
+    }
+    return count;
+}
+
+void TextureCache::log_stats() noexcept
+{
+    LOG_INIT_COUT();
+    log(LOG_INFO) << "TextureCache: " << hits << " hits, " << misses << " misses, "
+                  << get_live_count() << " live textures\n";
+}
+
+std::string TextureCache::make_file_key(const std::filesystem::path& file_path) noexcept
+{
+    // weakly_canonical resolves "..", "." and symlinks for the existing part
+    // of the path, so "models/../textures/a.jpg" and "textures/a.jpg" share
+    // an entry. Fall back to the absolute path if resolution fails.
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(file_path, ec);
+    if (ec)
+        canonical = std::filesystem::absolute(file_path, ec);
+
+    // Texture::load always uploads RGBA8 with mipmaps; the format is part of
+    // the key so a future variant of the same file doesn't alias it.
+    return "file:" + canonical.string() + "|rgba8|mip";
+}
+
+std::string TextureCache::make_solid_key(unsigned char r, unsigned char g, unsigned char b, unsigned char a) noexcept
+{
+    char key[32];
+    std::snprintf(key, sizeof(key), "solid:%02x%02x%02x%02x", r, g, b, a);
+    return key;
+}
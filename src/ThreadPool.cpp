@@ -0,0 +1,45 @@
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t thread_count) noexcept
+{
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    workers.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i)
+        workers.emplace_back([this]() { worker_loop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    condition.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::worker_loop() noexcept
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+            // Drain the queue before exiting so no future is left unresolved
+            if (stopping && tasks.empty())
+                return;
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
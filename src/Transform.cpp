@@ -0,0 +1,27 @@
+#include <Transform.hpp>
+
+#include <algorithm>
+
+namespace
+{
+    // Relative error allowed on the column lengths and angles
+    constexpr float UNIFORM_SCALE_TOLERANCE = 1e-4f;
+}
+
+glm::mat3 normal_matrix(const glm::mat4& model) noexcept
+{
+    const glm::mat3 linear{model};
+    const glm::vec3 x = linear[0];
+    const glm::vec3 y = linear[1];
+    const glm::vec3 z = linear[2];
+
+    // Columns of equal length and mutually orthogonal: M^T M = s^2 I, so the
+    // inverse transpose is M / s^2
+    const float xx = glm::dot(x, x);
+    const float tolerance = UNIFORM_SCALE_TOLERANCE * std::max(xx, 1e-12f);
+    if (glm::abs(glm::dot(y, y) - xx) <= tolerance && glm::abs(glm::dot(z, z) - xx) <= tolerance &&
+        glm::abs(glm::dot(x, y)) <= tolerance && glm::abs(glm::dot(x, z)) <= tolerance && glm::abs(glm::dot(y, z)) <= tolerance)
+        return linear;
+
+    return glm::transpose(glm::inverse(linear));
+}
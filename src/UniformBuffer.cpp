@@ -0,0 +1,45 @@
+#include <UniformBuffer.hpp>
+
+#include <BSlogger.hpp>
+
+UniformBuffer::UniformBuffer(const char* _block_name, GLuint _binding, std::size_t _size) noexcept
+    : block_name{_block_name}, binding{_binding}, size{_size}
+{
+    glGenBuffers(1, &buffer_id);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_id);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer_id);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    if (buffer_id != 0)
+    {
+        glDeleteBuffers(1, &buffer_id);
+        buffer_id = 0;
+    }
+}
+
+void UniformBuffer::attach(const Shader& shader) const noexcept
+{
+    shader.bind_uniform_block(block_name, binding, size);
+}
+
+void UniformBuffer::upload(const void* data, std::size_t data_size) noexcept
+{
+    if (data_size != size)
+    {
+        LOG_INIT_CERR();
+        log(LOG_ERR) << "UniformBuffer: " << block_name << " expects " << size << " bytes, got " << data_size << "\n";
+        return;
+    }
+
+    // Orphan first so the write never waits on draws still reading last
+    // frame's contents
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_id);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -1,5 +1,4 @@
 #include <Wall.hpp>
-#include <glm/gtc/type_ptr.hpp>
 
 Wall::Wall(std::shared_ptr<Mesh> mesh_, std::shared_ptr<Texture> albedo_, std::shared_ptr<Texture> normal_)
     : mesh(std::move(mesh_)), albedo(std::move(albedo_)), normal(std::move(normal_))
@@ -8,19 +7,25 @@ Wall::Wall(std::shared_ptr<Mesh> mesh_, std::shared_ptr<Texture> albedo_, std::s
 
 void Wall::render(const std::shared_ptr<Shader> &shader, const glm::mat4 &model) const
 {
-    glUniformMatrix4fv(shader->get_uniform_model_id(), 1, GL_FALSE, glm::value_ptr(model));
+    shader->set_model(model);
 
     // Use wall material (matte-ish)
-    glUniform1f(glGetUniformLocation(shader->get_program_id(), "material.shininess"), 64.0f);
+    glUniform1f(shader->get_uniform_location("material.shininess"_uniform), 64.0f);
 
+    // Panels of a wall share both maps, so only the first panel binds them
     if (albedo)
-        albedo->use();
+        albedo->use(0);
     if (normal)
-    {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normal->get_id());
-    }
+        normal->use(1);
 
     if (mesh)
         mesh->render();
 }
+
+void Wall::render_depth(const std::shared_ptr<Shader> &shader, const glm::mat4 &model) const
+{
+    shader->set_model(model);
+
+    if (mesh)
+        mesh->render_depth();
+}